@@ -61,7 +61,8 @@ htsmsg_field_destroy(htsmsg_t *msg, htsmsg_field_t *f)
   }
   if(f->hmf_flags & HMF_NAME_ALLOCED)
     free((void *)f->hmf_name);
-  free(f);
+  if(!(f->hmf_flags & HMF_ARENA))
+    free(f);
 }
 
 /*
@@ -298,6 +299,16 @@ htsmsg_get_s64(htsmsg_t *msg, const char *name, int64_t *s64p)
   if((f = htsmsg_field_find(msg, name)) == NULL)
     return HTSMSG_ERR_FIELD_NOT_FOUND;
 
+  return htsmsg_field_get_s64(f, s64p);
+}
+
+
+/**
+ *
+ */
+int
+htsmsg_field_get_s64(htsmsg_field_t *f, int64_t *s64p)
+{
   switch(f->hmf_type) {
   default:
     return HTSMSG_ERR_CONVERSION_IMPOSSIBLE;
@@ -62,6 +62,7 @@ typedef struct htsmsg_field {
 
 #define HMF_ALLOCED 0x1
 #define HMF_NAME_ALLOCED 0x2
+#define HMF_ARENA 0x4 /* field is part of the message's allocation */
 
   union {
     int64_t  s64;
@@ -238,6 +239,14 @@ htsmsg_t *htsmsg_get_map_multi(htsmsg_t *msg, ...);
  */
 const char *htsmsg_field_get_string(htsmsg_field_t *f);
 
+/**
+ * Given the field \p f, return it as a signed 64 bit integer.
+ *
+ * @return HTSMSG_ERR_CONVERSION_IMPOSSIBLE if the field is neither a string
+ *         nor an integer.
+ */
+int htsmsg_field_get_s64(htsmsg_field_t *f, int64_t *s64p);
+
 /**
  * Return the field \p name as an u32.
  *
@@ -135,6 +135,190 @@ htsmsg_binary_deserialize(const void *data, size_t len, const void *buf)
 
 
 
+/*
+ * Arena for htsmsg_binary_deserialize_arena
+ */
+typedef struct htsmsg_arena {
+  htsmsg_field_t *ha_fields;
+  char *ha_data;
+} htsmsg_arena_t;
+
+
+/*
+ * Validate a serialized message and count the memory needed to place it
+ * in an arena
+ */
+static int
+htsmsg_binary_measure(const uint8_t *buf, size_t len,
+		      size_t *fields, size_t *bytes)
+{
+  unsigned type, namelen, datalen;
+
+  while(len > 5) {
+
+    type    =  buf[0];
+    namelen =  buf[1];
+    datalen = (buf[2] << 24) |
+              (buf[3] << 16) |
+              (buf[4] << 8 ) |
+              (buf[5]      );
+
+    buf += 6;
+    len -= 6;
+
+    if(len < namelen + datalen)
+      return -1;
+
+    (*fields)++;
+    if(namelen > 0)
+      *bytes += namelen + 1;
+
+    buf += namelen;
+    len -= namelen;
+
+    switch(type) {
+    case HMF_STR:
+      *bytes += datalen + 1;
+      break;
+
+    case HMF_BIN:
+      *bytes += datalen;
+      break;
+
+    case HMF_S64:
+      break;
+
+    case HMF_MAP:
+    case HMF_LIST:
+      if(htsmsg_binary_measure(buf, datalen, fields, bytes) < 0)
+	return -1;
+      break;
+
+    default:
+      return -1;
+    }
+
+    buf += datalen;
+    len -= datalen;
+  }
+  return 0;
+}
+
+
+/*
+ * Like htsmsg_binary_des0, but all memory is taken from the arena. The
+ * message must have been validated by htsmsg_binary_measure.
+ */
+static void
+htsmsg_binary_des_arena(htsmsg_t *msg, const uint8_t *buf, size_t len,
+			htsmsg_arena_t *arena)
+{
+  unsigned type, namelen, datalen;
+  htsmsg_field_t *f;
+  htsmsg_t *sub;
+  char *n;
+  uint64_t u64;
+  int i;
+
+  while(len > 5) {
+
+    type    =  buf[0];
+    namelen =  buf[1];
+    datalen = (buf[2] << 24) |
+              (buf[3] << 16) |
+              (buf[4] << 8 ) |
+              (buf[5]      );
+
+    buf += 6;
+    len -= 6;
+
+    f = arena->ha_fields++;
+    f->hmf_type  = type;
+    f->hmf_flags = HMF_ARENA;
+
+    if(namelen > 0) {
+      n = arena->ha_data;
+      arena->ha_data += namelen + 1;
+      memcpy(n, buf, namelen);
+      n[namelen] = 0;
+
+      buf += namelen;
+      len -= namelen;
+    } else {
+      n = NULL;
+    }
+
+    f->hmf_name  = n;
+
+    switch(type) {
+    case HMF_STR:
+      f->hmf_str = n = arena->ha_data;
+      arena->ha_data += datalen + 1;
+      memcpy(n, buf, datalen);
+      n[datalen] = 0;
+      break;
+
+    case HMF_BIN:
+      f->hmf_bin = arena->ha_data;
+      f->hmf_binsize = datalen;
+      arena->ha_data += datalen;
+      memcpy((void *)f->hmf_bin, buf, datalen);
+      break;
+
+    case HMF_S64:
+      u64 = 0;
+      for(i = datalen - 1; i >= 0; i--)
+	  u64 = (u64 << 8) | buf[i];
+      f->hmf_s64 = u64;
+      break;
+
+    case HMF_MAP:
+    case HMF_LIST:
+      sub = &f->hmf_msg;
+      TAILQ_INIT(&sub->hm_fields);
+      sub->hm_data = NULL;
+      htsmsg_binary_des_arena(sub, buf, datalen, arena);
+      break;
+    }
+
+    TAILQ_INSERT_TAIL(&msg->hm_fields, f, hmf_link);
+    buf += datalen;
+    len -= datalen;
+  }
+}
+
+
+/*
+ * Layout: message, fields, names/strings/binary data. The message is
+ * freed last by htsmsg_destroy, which releases the whole arena.
+ */
+htsmsg_t *
+htsmsg_binary_deserialize_arena(const void *data, size_t len)
+{
+  size_t fields = 0, bytes = 0;
+  htsmsg_arena_t arena;
+  htsmsg_t *msg;
+
+  if(htsmsg_binary_measure(data, len, &fields, &bytes) < 0)
+    return NULL;
+
+  msg = malloc(sizeof(htsmsg_t) + fields * sizeof(htsmsg_field_t) + bytes);
+  if(msg == NULL)
+    return NULL;
+
+  TAILQ_INIT(&msg->hm_fields);
+  msg->hm_data = NULL;
+  msg->hm_islist = 0;
+
+  arena.ha_fields = (htsmsg_field_t *)(msg + 1);
+  arena.ha_data = (char *)(arena.ha_fields + fields);
+
+  htsmsg_binary_des_arena(msg, data, len, &arena);
+  return msg;
+}
+
+
+
 /*
  *
  */
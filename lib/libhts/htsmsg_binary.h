@@ -28,6 +28,16 @@
 htsmsg_t *htsmsg_binary_deserialize(const void *data, size_t len,
 				    const void *buf);
 
+/**
+ * htsmsg_binary_deserialize_arena
+ *
+ * Same as htsmsg_binary_deserialize, but the message with all its fields,
+ * names, strings and binary data is placed in a single allocation. The
+ * data is copied, so it may be released right after the call. The
+ * message is released with htsmsg_destroy as usual.
+ */
+htsmsg_t *htsmsg_binary_deserialize_arena(const void *data, size_t len);
+
 int htsmsg_binary_serialize(htsmsg_t *msg, void **datap, size_t *lenp,
 			    int maxlen);
 
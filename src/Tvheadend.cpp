@@ -11,6 +11,7 @@
 #include "tvheadend/HTSPConnection.h"
 #include "tvheadend/HTSPDemuxer.h"
 #include "tvheadend/HTSPMessage.h"
+#include "tvheadend/HTSPSchema.h"
 #include "tvheadend/HTSPVFS.h"
 #include "tvheadend/InstanceSettings.h"
 #include "tvheadend/utilities/LifetimeMapper.h"
@@ -20,35 +21,50 @@
 #include "kodi/General.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <limits>
 #include <memory>
 
 using namespace tvheadend;
 using namespace tvheadend::entity;
 using namespace tvheadend::utilities;
 
+#define DEMUX_INSTANCE_BUFFER_BUDGET (256 * 1024 * 1024) // bytes
+#define EPG_WINDOW_GRANULARITY (6 * 60 * 60) // secs
+#define EPG_LASTUPDATE_MARGIN (60) // secs
+
 CTvheadend::CTvheadend(const kodi::addon::IInstanceInfo& instance)
   : kodi::addon::CInstancePVRClient(instance),
     m_settings(new InstanceSettings(*this)),
     m_conn(new HTSPConnection(m_settings, *this)),
     m_customTimerProps(
         {CUSTOM_PROP_ID_DVR_CONFIGURATION, CUSTOM_PROP_ID_DVR_COMMENT}, *m_conn, m_dvrConfigs),
+    m_dmxBudget(DEMUX_INSTANCE_BUFFER_BUDGET),
+    m_dmxRoutes(std::max(1, m_settings->GetTotalTuners())),
     m_streamchange(false),
     m_queue(static_cast<size_t>(-1)),
+    m_epgStore(static_cast<size_t>(m_settings->GetEpgStoreSizeMB()) * 1024 * 1024),
     m_asyncState(m_settings->GetResponseTimeout()),
     m_timeRecordings(*m_conn, m_dvrConfigs),
     m_autoRecordings(m_settings, *m_conn, m_dvrConfigs),
     m_epgMaxDays(EpgMaxFutureDays()),
+    m_snapshot(kodi::addon::GetUserPath("metadata-" + std::to_string(instance.GetNumber()) +
+                                        ".bin"),
+               m_settings->GetUsername() + "@" + m_settings->GetHostname() + ":" +
+                   std::to_string(m_settings->GetPortHTSP()),
+               *m_conn),
     m_playingLiveStream(false)
 {
   m_dmx.reserve(m_settings->GetTotalTuners());
   for (int i = 0; i < 1 || i < m_settings->GetTotalTuners(); i++)
   {
-    m_dmx.emplace_back(new HTSPDemuxer(m_settings, *this, *m_conn));
+    m_dmx.emplace_back(new HTSPDemuxer(m_settings, *this, *m_conn, m_dmxBudget, m_dmxRoutes));
   }
   m_dmx_active = m_dmx[0];
+  m_epgStore.SetMaxPastDays(EpgMaxPastDays());
 }
 
 CTvheadend::~CTvheadend()
@@ -63,6 +79,17 @@ CTvheadend::~CTvheadend()
 
 void CTvheadend::Start()
 {
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if (m_snapshot.Load(m_channels, m_providers, m_tags))
+    {
+      for (const auto& entry : m_channels)
+        m_channelTuningPredictor.AddChannel(entry.second);
+
+      m_snapshotLoaded = true;
+    }
+  }
+
   CreateThread();
   m_conn->Start();
 }
@@ -74,6 +101,10 @@ void CTvheadend::Stop()
 
   m_conn->Stop();
   StopThread();
+
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  if (m_asyncState.GetState() == ASYNC_DONE)
+    m_snapshot.Save(m_channels, m_providers, m_tags);
 }
 
 /* **************************************************************************
@@ -155,17 +186,28 @@ error:
 
 std::string CTvheadend::GetImageURL(const char* str)
 {
-  if (*str != '/')
-  {
-    if (strncmp(str, "imagecache/", 11) == 0)
-      return m_conn->GetWebURL("/%s", str);
-
+  /* Absolute URLs are passed through, server paths are relative to its web root */
+  if (*str != '/' && strncmp(str, "imagecache/", 11) != 0)
     return str;
-  }
-  else
-  {
-    return m_conn->GetWebURL("%s", str);
-  }
+
+  return m_conn->GetWebURL(str);
+}
+
+int64_t CTvheadend::QueryServerTime(std::unique_lock<std::recursive_mutex>& lock)
+{
+  /* Send */
+  htsmsg_t* m = m_conn->SendAndWait0(lock, "getSysTime", htsmsg_create_map());
+
+  /* Validate */
+  if (!m)
+    return 0;
+
+  int64_t s64 = 0;
+  if (htsmsg_get_s64(m, "time", &s64))
+    Logger::Log(LogLevel::LEVEL_ERROR, "malformed getSysTime: 'time' missing");
+
+  htsmsg_destroy(m);
+  return s64;
 }
 
 void CTvheadend::QueryAvailableDvrConfigurations(std::unique_lock<std::recursive_mutex>& lock)
@@ -281,7 +323,7 @@ bool CTvheadend::HasStreamingProfile(const std::string& streamingProfile) const
 
 PVR_ERROR CTvheadend::GetProvidersAmount(int& amount)
 {
-  if (!m_asyncState.WaitForState(ASYNC_DVR))
+  if (!WaitForChannelList())
     return PVR_ERROR_FAILED;
 
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -321,7 +363,7 @@ PVR_ERROR CTvheadend::GetProviders(kodi::addon::PVRProvidersResultSet& results)
 
 PVR_ERROR CTvheadend::GetChannelGroupsAmount(int& amount)
 {
-  if (!m_asyncState.WaitForState(ASYNC_DVR))
+  if (!WaitForChannelList())
     return PVR_ERROR_FAILED;
 
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -331,7 +373,7 @@ PVR_ERROR CTvheadend::GetChannelGroupsAmount(int& amount)
 
 PVR_ERROR CTvheadend::GetChannelGroups(bool radio, kodi::addon::PVRChannelGroupsResultSet& results)
 {
-  if (!m_asyncState.WaitForState(ASYNC_DVR))
+  if (!WaitForChannelList())
     return PVR_ERROR_FAILED;
 
   std::vector<kodi::addon::PVRChannelGroup> tags;
@@ -369,7 +411,7 @@ PVR_ERROR CTvheadend::GetChannelGroups(bool radio, kodi::addon::PVRChannelGroups
 PVR_ERROR CTvheadend::GetChannelGroupMembers(const kodi::addon::PVRChannelGroup& group,
                                              kodi::addon::PVRChannelGroupMembersResultSet& results)
 {
-  if (!m_asyncState.WaitForState(ASYNC_DVR))
+  if (!WaitForChannelList())
     return PVR_ERROR_FAILED;
 
   std::vector<kodi::addon::PVRChannelGroupMember> gms;
@@ -418,7 +460,7 @@ PVR_ERROR CTvheadend::GetChannelGroupMembers(const kodi::addon::PVRChannelGroup&
 
 PVR_ERROR CTvheadend::GetChannelsAmount(int& amount)
 {
-  if (!m_asyncState.WaitForState(ASYNC_DVR))
+  if (!WaitForChannelList())
     return PVR_ERROR_FAILED;
 
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -428,7 +470,7 @@ PVR_ERROR CTvheadend::GetChannelsAmount(int& amount)
 
 PVR_ERROR CTvheadend::GetChannels(bool radio, kodi::addon::PVRChannelsResultSet& results)
 {
-  if (!m_asyncState.WaitForState(ASYNC_DVR))
+  if (!WaitForChannelList())
     return PVR_ERROR_FAILED;
 
   std::vector<kodi::addon::PVRChannel> channels;
@@ -489,7 +531,7 @@ PVR_ERROR CTvheadend::GetChannelStreamProperties(
   if (!streamingProfile.empty())
     path += "?profile=" + streamingProfile;
 
-  const std::string url = m_conn->GetWebURL("%s", path.c_str());
+  const std::string url = m_conn->GetWebURL(path.c_str());
 
   properties.emplace_back(PVR_STREAM_PROPERTY_STREAMURL, url);
   properties.emplace_back(PVR_STREAM_PROPERTY_ISREALTIMESTREAM, "true");
@@ -1555,6 +1597,30 @@ PVR_ERROR CTvheadend::GetEPGForChannel(int channelUid,
   Logger::Log(LogLevel::LEVEL_DEBUG, "get epg channel %d start %lld stop %lld", channelUid,
               static_cast<long long>(start), static_cast<long long>(end));
 
+  /* Answer from the local store, if it holds all events of the requested time range */
+  bool sweep = false;
+  {
+    std::unique_lock<std::recursive_mutex> lock(m_mutex);
+    sweep = m_settings->GetAsyncEpg() && m_asyncState.GetState() == ASYNC_DONE &&
+            (m_syncEpgMaxTime == 0 || end <= m_syncEpgMaxTime);
+
+    if (sweep && m_epgStore.IsComplete(channelUid, start, end))
+    {
+      std::vector<Event> events;
+      m_epgStore.GetEvents(channelUid, start, end, events);
+      lock.unlock();
+
+      for (const auto& event : events)
+      {
+        /* Callback. */
+        TransferEvent(results, event);
+      }
+      Logger::Log(LogLevel::LEVEL_DEBUG, "get epg channel %d events %zu (local)", channelUid,
+                  events.size());
+      return PVR_ERROR_NO_ERROR;
+    }
+  }
+
   /* Build message */
   htsmsg_t* msg = htsmsg_create_map();
   htsmsg_add_u32(msg, "channelId", channelUid);
@@ -1578,6 +1644,10 @@ PVR_ERROR CTvheadend::GetEPGForChannel(int channelUid,
     return PVR_ERROR_SERVER_ERROR;
   }
 
+  /* The answer holds all events from the one currently running on */
+  const time_t now = std::time(nullptr);
+  std::vector<Event> events;
+
   int n = 0;
   HTSMSG_FOREACH(f, l)
   {
@@ -1589,12 +1659,22 @@ PVR_ERROR CTvheadend::GetEPGForChannel(int channelUid,
         /* Callback. */
         TransferEvent(results, event);
         ++n;
+
+        if (sweep)
+          events.emplace_back(event);
       }
     }
   }
   htsmsg_destroy(msg);
   Logger::Log(LogLevel::LEVEL_DEBUG, "get epg channel %d events %d", channelUid, n);
 
+  /* Drop the events the store missed the deletion of, so that it can answer from now on */
+  if (sweep)
+  {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    m_epgStore.Sweep(channelUid, now, end, events);
+  }
+
   return PVR_ERROR_NO_ERROR;
 }
 
@@ -1616,6 +1696,13 @@ PVR_ERROR CTvheadend::SetEPGMaxFutureDays(int iFutureDays)
   return PVR_ERROR_NO_ERROR;
 }
 
+PVR_ERROR CTvheadend::SetEPGMaxPastDays(int iPastDays)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  m_epgStore.SetMaxPastDays(iPastDays);
+  return PVR_ERROR_NO_ERROR;
+}
+
 /* **************************************************************************
  * Connection
  * *************************************************************************/
@@ -1651,15 +1738,45 @@ bool CTvheadend::Connected(std::unique_lock<std::recursive_mutex>& lock)
   if (m_asyncState.GetState() == ASYNC_NONE)
     m_asyncState.SetState(ASYNC_INIT);
 
+  /* The EPG window is rounded up, so that it is the same for reconnects in short succession */
+  int64_t epgMaxTime = 0;
+  if (m_settings->GetAsyncEpg() && m_epgMaxDays > EPG_TIMEFRAME_UNLIMITED)
+  {
+    epgMaxTime = static_cast<int64_t>(std::time(nullptr) + m_epgMaxDays * int64_t(24 * 60 * 60));
+    epgMaxTime += EPG_WINDOW_GRANULARITY - epgMaxTime % EPG_WINDOW_GRANULARITY;
+  }
+
+  /* Everything updated from now on will be received by this sync */
+  m_pendingLastUpdate = QueryServerTime(lock);
+  m_pendingEpgMaxTime = epgMaxTime;
+
+  /* Not served until swept, it is incomplete while the sync is running */
+  m_epgStore.ResetSwept();
+  m_pendingEpgStoreSwept = false;
+
   htsmsg_t* msg = htsmsg_create_map();
   if (m_settings->GetAsyncEpg())
   {
     Logger::Log(LogLevel::LEVEL_INFO, "Request async EPG (%d days)", m_epgMaxDays);
     htsmsg_add_u32(msg, "epg", 1);
-    if (m_epgMaxDays > EPG_TIMEFRAME_UNLIMITED)
-      htsmsg_add_s64(
-          msg, "epgMaxTime",
-          static_cast<int64_t>(std::time(nullptr) + m_epgMaxDays * int64_t(24 * 60 * 60)));
+    if (epgMaxTime > 0)
+      htsmsg_add_s64(msg, "epgMaxTime", epgMaxTime);
+
+    /* Only request the events changed since the last completed sync of the same EPG window.
+     * Anything else (first sync, interrupted sync, changed window) falls back to a full sync. */
+    if (m_asyncState.GetState() == ASYNC_DONE && m_syncLastUpdate > 0 &&
+        m_syncEpgMaxTime == epgMaxTime)
+    {
+      Logger::Log(LogLevel::LEVEL_INFO, "Request EPG changes since %lld",
+                  static_cast<long long>(m_syncLastUpdate));
+      htsmsg_add_s64(msg, "lastUpdate", m_syncLastUpdate - EPG_LASTUPDATE_MARGIN);
+    }
+    else
+    {
+      /* All events are sent again, this also drops the events deleted while disconnected */
+      m_epgStore.Clear();
+      m_pendingEpgStoreSwept = true;
+    }
   }
   else
     htsmsg_add_u32(msg, "epg", 0);
@@ -1693,6 +1810,12 @@ PVR_ERROR CTvheadend::GetBackendVersion(std::string& version)
 PVR_ERROR CTvheadend::GetConnectionString(std::string& connection)
 {
   connection = m_conn->GetServerString();
+
+  /* Shown in Kodi's system info, tells about an unstable connection */
+  const uint32_t reconnects = m_conn->GetReconnectCount();
+  if (reconnects > 0)
+    connection += kodi::tools::StringUtils::Format(" (%u reconnects)", reconnects);
+
   return PVR_ERROR_NO_ERROR;
 }
 
@@ -1741,6 +1864,12 @@ bool CTvheadend::OpenRecordedStream(const kodi::addon::PVRRecording& recording,
 
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
   m_vfs.insert({streamId, vfs});
+
+  const auto it = m_recordings.find(std::stoul(vfs->GetRecordingId()));
+  if (it != m_recordings.end())
+    vfs->UpdateFilesSize(it->second.GetFilesSize(),
+                         it->second.GetState() == PVR_TIMER_STATE_RECORDING);
+
   return true;
 }
 
@@ -1812,6 +1941,7 @@ int64_t CTvheadend::SeekRecordedStream(int64_t streamId, int64_t position, int w
 int64_t CTvheadend::LengthRecordedStream(int64_t streamId)
 {
   std::shared_ptr<HTSPVFS> vfs;
+  bool isRecordingInProgress{false};
   {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
@@ -1820,9 +1950,13 @@ int64_t CTvheadend::LengthRecordedStream(int64_t streamId)
       return 0;
 
     vfs = (*it).second;
+
+    auto it2 = m_recordings.find(std::stoul(vfs->GetRecordingId()));
+    if (it2 != m_recordings.end())
+      isRecordingInProgress = ((*it2).second.GetState() == PVR_TIMER_STATE_RECORDING);
   }
 
-  const int64_t size = vfs->Size();
+  const int64_t size = vfs->Size(isRecordingInProgress);
   return size < 0 ? 0 : size;
 }
 
@@ -1912,12 +2046,8 @@ bool CTvheadend::ProcessMessage(const std::string& method, htsmsg_t* msg)
   if (!htsmsg_get_u32(msg, "subscriptionId", &subId))
   {
     /* subscriptionId found - for a Demuxer */
-    for (auto* dmx : m_dmx)
-    {
-      if (dmx->GetSubscriptionId() == subId)
-        return dmx->ProcessMessage(method, msg);
-    }
-    return true;
+    HTSPDemuxer* dmx = m_dmxRoutes.Find(subId);
+    return dmx ? dmx->ProcessMessage(method, msg) : true;
   }
 
   /* Store */
@@ -1925,6 +2055,13 @@ bool CTvheadend::ProcessMessage(const std::string& method, htsmsg_t* msg)
   return false;
 }
 
+void CTvheadend::ProcessMuxPacket(const HTSPMuxPacket& pkt)
+{
+  HTSPDemuxer* dmx = m_dmxRoutes.Find(pkt.subscriptionId);
+  if (dmx)
+    dmx->ProcessMuxPacket(pkt);
+}
+
 void CTvheadend::ConnectionStateChange(const std::string& connectionString,
                                        PVR_CONNECTION_STATE newState,
                                        const std::string& message)
@@ -1958,6 +2095,40 @@ void CTvheadend::CloseExpiredSubscriptions()
   }
 }
 
+void CTvheadend::SetActiveDemuxer(HTSPDemuxer* dmx)
+{
+  std::lock_guard<std::mutex> lock(m_dmxTrimMutex);
+  SetActiveDemuxer0(dmx);
+}
+
+void CTvheadend::SetActiveDemuxer0(HTSPDemuxer* dmx)
+{
+  m_dmx_active = dmx;
+
+  for (auto* standby : m_dmx)
+    standby->SetStandby(standby != dmx);
+}
+
+void CTvheadend::TrimStandbyDemuxers()
+{
+  // predictive tuning active?
+  if (m_dmx.size() > 1)
+  {
+    const time_t now = std::time(nullptr);
+    if (now == m_lastDmxTrim)
+      return;
+
+    m_lastDmxTrim = now;
+
+    std::lock_guard<std::mutex> lock(m_dmxTrimMutex);
+    for (auto* dmx : m_dmx)
+    {
+      if (dmx != m_dmx_active)
+        dmx->Trim();
+    }
+  }
+}
+
 void CTvheadend::Process()
 {
   while (!m_threadStop)
@@ -1965,7 +2136,7 @@ void CTvheadend::Process()
     /* Check Q */
     // this is a bit horrible, but meh
     HTSPMessage msg = {};
-    bool bSuccess = m_queue.Pop(msg, 2000);
+    bool bSuccess = m_queue.Pop(msg, 1000);
 
     if (m_threadStop)
       continue;
@@ -1973,6 +2144,9 @@ void CTvheadend::Process()
     // check for expired predictive tuning subscriptions and close those
     CloseExpiredSubscriptions();
 
+    // drop what is not needed to start playback of standby subscriptions
+    TrimStandbyDemuxers();
+
     if (!bSuccess || !msg.GetHTSPMessage())
       continue;
 
@@ -2057,9 +2231,9 @@ void CTvheadend::Process()
       else
         Logger::Log(LogLevel::LEVEL_DEBUG, "unhandled message [%s]", method.c_str());
 
-      /* make a copy of events list to process it without lock. */
-      eventsCopy = m_events;
-      m_events.clear();
+      /* take the events list to process it without lock. */
+      eventsCopy.swap(m_events);
+      m_epgEvents.clear();
     }
 
     /* Manual delete rather than waiting */
@@ -2126,10 +2300,18 @@ void CTvheadend::TriggerTimerUpdate()
 
 void CTvheadend::PushEpgEventUpdate(const Event& epg, EPG_EVENT_STATE state)
 {
-  SHTSPEvent event = SHTSPEvent(HTSP_EVENT_EPG_UPDATE, epg, state);
+  const SHTSPEventKey key{epg.GetId(), epg.GetChannel(), state};
 
-  if (std::find(m_events.begin(), m_events.end(), event) == m_events.end())
-    m_events.emplace_back(std::move(event));
+  /* Last writer wins: a newer update replaces a pending one for the same event */
+  const auto it = m_epgEvents.find(key);
+  if (it != m_epgEvents.end())
+  {
+    m_events[it->second].m_epg = epg;
+    return;
+  }
+
+  m_epgEvents.emplace(key, m_events.size());
+  m_events.emplace_back(SHTSPEvent(HTSP_EVENT_EPG_UPDATE, epg, state));
 }
 
 void CTvheadend::SyncInitCompleted()
@@ -2273,6 +2455,9 @@ void CTvheadend::SyncEpgCompleted()
 
   for (auto& entry : deletedEvents)
   {
+    m_eventChannels.erase(entry.first);
+    m_epgStore.Remove(entry.second, entry.first);
+
     /* Transfer event to Kodi (callback) */
     Event evt;
     evt.SetId(entry.first);
@@ -2290,17 +2475,69 @@ void CTvheadend::SyncCompleted()
 
   m_asyncState.SetState(ASYNC_DONE);
 
+  /* Following reconnects only need the changes since this sync */
+  m_syncLastUpdate = m_pendingLastUpdate;
+  m_syncEpgMaxTime = m_pendingEpgMaxTime;
+  if (m_pendingEpgStoreSwept)
+    m_epgStore.SetSwept(m_syncEpgMaxTime > 0 ? static_cast<time_t>(m_syncEpgMaxTime)
+                                             : std::numeric_limits<time_t>::max());
+
+  /* Refresh the snapshot for the next start */
+  m_snapshot.Save(m_channels, m_providers, m_tags);
+
+  if (m_settings->GetAsyncEpg())
+    m_epgStore.LogMemoryUsage();
+
   Logger::Log(LogLevel::LEVEL_INFO, "Async updates initialised");
 }
 
+bool CTvheadend::WaitForChannelList()
+{
+  /* The snapshot is served until the server's channel list arrived; the sync then reconciles it */
+  return m_snapshotLoaded || m_asyncState.WaitForState(ASYNC_DVR);
+}
+
+namespace
+{
+
+/* tagAdd/tagUpdate */
+constexpr HTSPSchema TAG_SCHEMA({"tagId", "tagIndex", "tagName", "tagIcon", "members"});
+
+/* channelAdd/channelUpdate */
+constexpr HTSPSchema CHANNEL_SCHEMA({"channelId", "channelName", "channelNumber",
+                                     "channelNumberMinor", "channelIcon", "services"});
+
+/* dvrEntryAdd/dvrEntryUpdate */
+constexpr HTSPSchema RECORDING_SCHEMA({"id", "duplicate", "error", "start", "stop", "channel",
+                                       "files", "channelName", "startExtra", "stopExtra", "removal",
+                                       "priority", "state", "eventId", "enabled", "title",
+                                       "subtitle", "path", "description", "summary", "contentType",
+                                       "timerecId", "autorecId", "image", "fanartImage",
+                                       "ageRating", "ratingLabel", "ratingIcon", "ratingAuthority",
+                                       "ratingCountry", "configId", "comment", "subscriptionError",
+                                       "playcount", "playposition", "seasonNumber", "episodeNumber",
+                                       "partNumber"});
+
+/* eventAdd/eventUpdate, getEvents */
+constexpr HTSPSchema EVENT_SCHEMA({"eventId", "channelId", "start", "stop", "title", "subtitle",
+                                   "summary", "description", "image", "nextEventId", "contentType",
+                                   "starRating", "ageRating", "ratingLabel", "ratingIcon",
+                                   "ratingAuthority", "ratingCountry", "firstAired", "seasonNumber",
+                                   "episodeNumber", "partNumber", "serieslinkUri", "copyrightYear",
+                                   "dvrId", "credits", "category"});
+
+} // unnamed namespace
+
 void CTvheadend::ParseTagAddOrUpdate(htsmsg_t* msg, bool bAdd)
 {
+  const HTSPFields fields(TAG_SCHEMA, msg);
+
   /* Rebuild state upon arrival of first async data */
   SyncInitCompleted();
 
   /* Validate */
   uint32_t u32 = 0;
-  if (htsmsg_get_u32(msg, "tagId", &u32))
+  if (fields.GetU32("tagId", &u32))
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed tagAdd/tagUpdate: 'tagId' missing");
     return;
@@ -2321,11 +2558,11 @@ void CTvheadend::ParseTagAddOrUpdate(htsmsg_t* msg, bool bAdd)
   tag.SetId(u32);
 
   /* Index */
-  if (!htsmsg_get_u32(msg, "tagIndex", &u32))
+  if (!fields.GetU32("tagIndex", &u32))
     tag.SetIndex(u32);
 
   /* Name */
-  const char* str = htsmsg_get_str(msg, "tagName");
+  const char* str = fields.GetStr("tagName");
   if (str)
   {
     tag.SetName(str);
@@ -2337,12 +2574,12 @@ void CTvheadend::ParseTagAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   /* Icon */
-  str = htsmsg_get_str(msg, "tagIcon");
+  str = fields.GetStr("tagIcon");
   if (str)
     tag.SetIcon(GetImageURL(str));
 
   /* Members */
-  htsmsg_t* list = htsmsg_get_list(msg, "members");
+  htsmsg_t* list = fields.GetList("members");
   if (list)
   {
     htsmsg_field_t* f;
@@ -2384,12 +2621,14 @@ void CTvheadend::ParseTagDelete(htsmsg_t* msg)
 
 void CTvheadend::ParseChannelAddOrUpdate(htsmsg_t* msg, bool bAdd)
 {
+  const HTSPFields fields(CHANNEL_SCHEMA, msg);
+
   /* Rebuild state upon arrival of first async data */
   SyncInitCompleted();
 
   /* Validate */
   uint32_t u32 = 0;
-  if (htsmsg_get_u32(msg, "channelId", &u32))
+  if (fields.GetU32("channelId", &u32))
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed channelAdd/channelUpdate: 'channelId' missing");
     return;
@@ -2402,7 +2641,7 @@ void CTvheadend::ParseChannelAddOrUpdate(htsmsg_t* msg, bool bAdd)
   channel.SetDirty(false);
 
   /* Channel name */
-  const char* str = htsmsg_get_str(msg, "channelName");
+  const char* str = fields.GetStr("channelName");
   if (str)
   {
     channel.SetName(str);
@@ -2414,7 +2653,7 @@ void CTvheadend::ParseChannelAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   /* Channel number */
-  if (!htsmsg_get_u32(msg, "channelNumber", &u32))
+  if (!fields.GetU32("channelNumber", &u32))
   {
     if (!u32)
       u32 = GetNextUnnumberedChannelNumber();
@@ -2429,16 +2668,16 @@ void CTvheadend::ParseChannelAddOrUpdate(htsmsg_t* msg, bool bAdd)
     channel.SetNum(GetNextUnnumberedChannelNumber());
 
   /* ATSC subchannel number */
-  if (!htsmsg_get_u32(msg, "channelNumberMinor", &u32))
+  if (!fields.GetU32("channelNumberMinor", &u32))
     channel.SetNumMinor(u32);
 
   /* Channel icon */
-  str = htsmsg_get_str(msg, "channelIcon");
+  str = fields.GetStr("channelIcon");
   if (str)
     channel.SetIcon(GetImageURL(str));
 
   /* Services */
-  htsmsg_t* list = htsmsg_get_list(msg, "services");
+  htsmsg_t* list = fields.GetList("services");
   if (list)
   {
     htsmsg_field_t* f = nullptr;
@@ -2539,12 +2778,14 @@ void CTvheadend::ParseChannelDelete(htsmsg_t* msg)
 
 void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
 {
+  const HTSPFields fields(RECORDING_SCHEMA, msg);
+
   /* Channels complete */
   SyncChannelsCompleted();
 
   /* Validate */
   uint32_t id = 0;
-  if (htsmsg_get_u32(msg, "id", &id))
+  if (fields.GetU32("id", &id))
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed dvrEntryAdd/dvrEntryUpdate: 'id' missing");
     return;
@@ -2552,12 +2793,12 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
 
   /* Ignore duplicates */
   uint32_t dup = 0;
-  if (m_settings->GetIgnoreDuplicateSchedules() && !htsmsg_get_u32(msg, "duplicate", &dup) &&
+  if (m_settings->GetIgnoreDuplicateSchedules() && !fields.GetU32("duplicate", &dup) &&
       dup == 1)
     return;
 
   /* Ignore recordings without a file (e.g. removed recordings) */
-  const char* error = htsmsg_get_str(msg, "error");
+  const char* error = fields.GetStr("error");
   if (error && (strstr(error, "missing") != nullptr))
   {
     const auto it = m_recordings.find(id);
@@ -2582,7 +2823,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
 
   // Set the time the recording was scheduled to start. This may differ from the actual start.
   int64_t start = 0;
-  if (!htsmsg_get_s64(msg, "start", &start))
+  if (!fields.GetS64("start", &start))
     rec.SetStart(start);
   else if (bAdd)
   {
@@ -2592,7 +2833,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
 
   // Set the time the recording was scheduled to stop. This may differ from the actual stop.
   int64_t stop = 0;
-  if (!htsmsg_get_s64(msg, "stop", &stop))
+  if (!fields.GetS64("stop", &stop))
     rec.SetStop(stop);
   else if (bAdd)
   {
@@ -2602,7 +2843,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
 
   /* Channel is optional, it may not exist anymore */
   uint32_t channel = 0;
-  if (!htsmsg_get_u32(msg, "channel", &channel))
+  if (!fields.GetU32("channel", &channel))
   {
     /* Channel Id */
     rec.SetChannel(channel);
@@ -2618,7 +2859,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
     }
   }
 
-  htsmsg_t* files = htsmsg_get_list(msg, "files");
+  htsmsg_t* files = fields.GetList("files");
   if (files)
   {
     bool needChannelType = !rec.GetChannelType();
@@ -2690,13 +2931,13 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   /* Channel name fallback (in case channel was deleted) */
   if (rec.GetChannelName().empty())
   {
-    const char* str = htsmsg_get_str(msg, "channelName");
+    const char* str = fields.GetStr("channelName");
     if (str)
       rec.SetChannelName(str);
   }
 
   int64_t startExtra = 0;
-  if (!htsmsg_get_s64(msg, "startExtra", &startExtra))
+  if (!fields.GetS64("startExtra", &startExtra))
     rec.SetStartExtra(startExtra);
   else if (bAdd)
   {
@@ -2705,7 +2946,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   int64_t stopExtra = 0;
-  if (!htsmsg_get_s64(msg, "stopExtra", &stopExtra))
+  if (!fields.GetS64("stopExtra", &stopExtra))
     rec.SetStopExtra(stopExtra);
   else if (bAdd)
   {
@@ -2714,7 +2955,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   uint32_t removal = 0;
-  if (!htsmsg_get_u32(msg, "removal", &removal))
+  if (!fields.GetU32("removal", &removal))
   {
     rec.SetLifetime(removal);
   }
@@ -2725,7 +2966,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   uint32_t priority = 0;
-  if (!htsmsg_get_u32(msg, "priority", &priority))
+  if (!fields.GetU32("priority", &priority))
   {
     switch (priority)
     {
@@ -2750,7 +2991,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   /* Parse state */
-  const char* state = htsmsg_get_str(msg, "state");
+  const char* state = fields.GetStr("state");
   if (state)
   {
     if (strstr(state, "scheduled"))
@@ -2772,86 +3013,86 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
 
   /* Add optional fields */
   uint32_t eventId = 0;
-  if (!htsmsg_get_u32(msg, "eventId", &eventId))
+  if (!fields.GetU32("eventId", &eventId))
     rec.SetEventId(eventId);
 
   uint32_t enabled = 0;
-  if (!htsmsg_get_u32(msg, "enabled", &enabled))
+  if (!fields.GetU32("enabled", &enabled))
     rec.SetEnabled(enabled);
 
-  const char* str = htsmsg_get_str(msg, "title");
+  const char* str = fields.GetStr("title");
   if (str)
     rec.SetTitle(str);
 
-  str = htsmsg_get_str(msg, "subtitle");
+  str = fields.GetStr("subtitle");
   if (str)
     rec.SetSubtitle(str);
 
-  str = htsmsg_get_str(msg, "path");
+  str = fields.GetStr("path");
   if (str)
     rec.SetPath(str);
 
-  str = htsmsg_get_str(msg, "description");
+  str = fields.GetStr("description");
   if (str)
   {
     rec.SetDescription(str);
   }
   else
   {
-    str = htsmsg_get_str(msg, "summary");
+    str = fields.GetStr("summary");
     if (str)
       rec.SetDescription(str);
   }
 
   uint32_t contentType = 0;
-  if (!htsmsg_get_u32(msg, "contentType", &contentType))
+  if (!fields.GetU32("contentType", &contentType))
     rec.SetContentType(contentType);
 
-  str = htsmsg_get_str(msg, "timerecId");
+  str = fields.GetStr("timerecId");
   if (str)
     rec.SetTimerecId(str);
 
-  str = htsmsg_get_str(msg, "autorecId");
+  str = fields.GetStr("autorecId");
   if (str)
     rec.SetAutorecId(str);
 
-  str = htsmsg_get_str(msg, "image");
+  str = fields.GetStr("image");
   if (str)
     rec.SetImage(GetImageURL(str));
 
-  str = htsmsg_get_str(msg, "fanartImage");
+  str = fields.GetStr("fanartImage");
   if (str)
     rec.SetFanartImage(GetImageURL(str));
 
   uint32_t ageRating = 0;
-  if (!htsmsg_get_u32(msg, "ageRating", &ageRating))
+  if (!fields.GetU32("ageRating", &ageRating))
     rec.SetAgeRating(ageRating);
 
-  str = htsmsg_get_str(msg, "ratingLabel");
+  str = fields.GetStr("ratingLabel");
   if (str)
     rec.SetRatingLabel(str);
 
-  str = htsmsg_get_str(msg, "ratingIcon");
+  str = fields.GetStr("ratingIcon");
   if (str)
     rec.SetRatingIcon(GetImageURL(str));
 
-  str = htsmsg_get_str(msg, "ratingAuthority");
+  str = fields.GetStr("ratingAuthority");
   if (str)
   {
     rec.SetRatingSource(str);
   }
   else
   {
-    str = htsmsg_get_str(msg, "ratingCountry");
+    str = fields.GetStr("ratingCountry");
     if (str)
       rec.SetRatingSource(str);
   }
 
-  str = htsmsg_get_str(msg, "configId");
+  str = fields.GetStr("configId");
   if (str)
     rec.SetConfigUuid(str);
 
-  str = htsmsg_get_str(msg, "comment");
+  str = fields.GetStr("comment");
   if (str)
     rec.SetComment(str);
 
@@ -2885,7 +3126,7 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   {
     /* Parse subscription error */
     /* This field is absent when everything is fine or when htsp version < 20 */
-    str = htsmsg_get_str(msg, "subscriptionError");
+    str = fields.GetStr("subscriptionError");
     if (str)
     {
       /* No free adapter, AKA subscription conflict */
@@ -2898,27 +3139,39 @@ void CTvheadend::ParseRecordingAddOrUpdate(htsmsg_t* msg, bool bAdd)
   if (m_conn->GetProtocol() >= 27)
   {
     uint32_t playCount = 0;
-    if (!htsmsg_get_u32(msg, "playcount", &playCount))
+    if (!fields.GetU32("playcount", &playCount))
       rec.SetPlayCount(playCount);
 
     uint32_t playPosition = 0;
-    if (!htsmsg_get_u32(msg, "playposition", &playPosition))
+    if (!fields.GetU32("playposition", &playPosition))
       rec.SetPlayPosition(playPosition);
   }
 
   /* season/episode/part */
   uint32_t season = 0;
-  if (!htsmsg_get_u32(msg, "seasonNumber", &season))
+  if (!fields.GetU32("seasonNumber", &season))
     rec.SetSeason(static_cast<int32_t>(season));
 
   uint32_t episode = 0;
-  if (!htsmsg_get_u32(msg, "episodeNumber", &episode))
+  if (!fields.GetU32("episodeNumber", &episode))
     rec.SetEpisode(static_cast<int32_t>(episode));
 
   uint32_t part = 0;
-  if (!htsmsg_get_u32(msg, "partNumber", &part))
+  if (!fields.GetU32("partNumber", &part))
     rec.SetPart(static_cast<int32_t>(part));
 
+  /* Open recordings take their size from here, instead of asking the server */
+  if (rec.GetFilesSize() != comparison.GetFilesSize() || rec.GetState() != comparison.GetState())
+  {
+    const std::string recordingId = std::to_string(id);
+    for (const auto& vfs : m_vfs)
+    {
+      if (vfs.second->GetRecordingId() == recordingId)
+        vfs.second->UpdateFilesSize(rec.GetFilesSize(),
+                                    rec.GetState() == PVR_TIMER_STATE_RECORDING);
+    }
+  }
+
   /* Update */
   if (rec != comparison)
   {
@@ -2959,33 +3212,35 @@ void CTvheadend::ParseRecordingDelete(htsmsg_t* msg)
 
 bool CTvheadend::ParseEvent(htsmsg_t* msg, bool bAdd, Event& evt)
 {
+  const HTSPFields fields(EVENT_SCHEMA, msg);
+
   /* Recordings complete */
   SyncDvrCompleted();
 
   /* Validate */
   uint32_t id = 0;
-  if (htsmsg_get_u32(msg, "eventId", &id))
+  if (fields.GetU32("eventId", &id))
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed eventAdd/eventUpdate: 'eventId' missing");
     return false;
   }
 
   uint32_t channel = 0;
-  if (htsmsg_get_u32(msg, "channelId", &channel) && bAdd)
+  if (fields.GetU32("channelId", &channel) && bAdd)
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed eventAdd: 'channelId' missing");
     return false;
   }
 
   int64_t start = 0;
-  if (htsmsg_get_s64(msg, "start", &start) && bAdd)
+  if (fields.GetS64("start", &start) && bAdd)
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed eventAdd: 'start' missing");
     return false;
   }
 
   int64_t stop = 0;
-  if (htsmsg_get_s64(msg, "stop", &stop) && bAdd)
+  if (fields.GetS64("stop", &stop) && bAdd)
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "malformed eventAdd: 'stop' missing");
     return false;
@@ -2997,73 +3252,73 @@ bool CTvheadend::ParseEvent(htsmsg_t* msg, bool bAdd, Event& evt)
   evt.SetStop(static_cast<time_t>(stop));
 
   /* Add optional fields */
-  const char* str = htsmsg_get_str(msg, "title");
+  const char* str = fields.GetStr("title");
   if (str)
     evt.SetTitle(str);
 
-  str = htsmsg_get_str(msg, "subtitle");
+  str = fields.GetStr("subtitle");
   if (str)
     evt.SetSubtitle(str);
 
-  str = htsmsg_get_str(msg, "summary");
+  str = fields.GetStr("summary");
   if (str)
     evt.SetSummary(str);
 
-  str = htsmsg_get_str(msg, "description");
+  str = fields.GetStr("description");
   if (str)
     evt.SetDesc(str);
 
-  str = htsmsg_get_str(msg, "image");
+  str = fields.GetStr("image");
   if (str)
     evt.SetImage(GetImageURL(str));
 
   uint32_t u32 = 0;
-  if (!htsmsg_get_u32(msg, "nextEventId", &u32))
+  if (!fields.GetU32("nextEventId", &u32))
     evt.SetNext(u32);
-  if (!htsmsg_get_u32(msg, "contentType", &u32))
+  if (!fields.GetU32("contentType", &u32))
     evt.SetContent(u32);
-  if (!htsmsg_get_u32(msg, "starRating", &u32))
+  if (!fields.GetU32("starRating", &u32))
     evt.SetStars(u32);
-  if (!htsmsg_get_u32(msg, "ageRating", &u32))
+  if (!fields.GetU32("ageRating", &u32))
     evt.SetAge(u32);
 
-  str = htsmsg_get_str(msg, "ratingLabel"); // HTSP v36 required
+  str = fields.GetStr("ratingLabel"); // HTSP v36 required
   if (str)
     evt.SetRatingLabel(str);
 
-  str = htsmsg_get_str(msg, "ratingIcon"); // HTSP v36 required
+  str = fields.GetStr("ratingIcon"); // HTSP v36 required
   if (str)
     evt.SetRatingIcon(GetImageURL(str));
 
-  str = htsmsg_get_str(msg, "ratingAuthority");
+  str = fields.GetStr("ratingAuthority");
   if (str)
   {
     evt.SetRatingSource(str);
   }
   else
   {
-    str = htsmsg_get_str(msg, "ratingCountry");
+    str = fields.GetStr("ratingCountry");
     if (str)
       evt.SetRatingSource(str);
   }
 
   int64_t s64 = 0;
-  if (!htsmsg_get_s64(msg, "firstAired", &s64))
+  if (!fields.GetS64("firstAired", &s64))
     evt.SetAired(static_cast<time_t>(s64));
-  if (!htsmsg_get_u32(msg, "seasonNumber", &u32))
+  if (!fields.GetU32("seasonNumber", &u32))
     evt.SetSeason(static_cast<int32_t>(u32));
-  if (!htsmsg_get_u32(msg, "episodeNumber", &u32))
+  if (!fields.GetU32("episodeNumber", &u32))
     evt.SetEpisode(static_cast<int32_t>(u32));
-  if (!htsmsg_get_u32(msg, "partNumber", &u32))
+  if (!fields.GetU32("partNumber", &u32))
     evt.SetPart(u32);
 
-  str = htsmsg_get_str(msg, "serieslinkUri");
+  str = fields.GetStr("serieslinkUri");
   if (str)
     evt.SetSeriesLink(str);
 
-  if (!htsmsg_get_u32(msg, "copyrightYear", &u32))
+  if (!fields.GetU32("copyrightYear", &u32))
     evt.SetYear(u32);
-  if (!htsmsg_get_u32(msg, "dvrId", &u32))
+  if (!fields.GetU32("dvrId", &u32))
     evt.SetRecordingId(u32);
 
   if (m_conn->GetProtocol() >= 32)
@@ -3091,7 +3346,7 @@ bool CTvheadend::ParseEvent(htsmsg_t* msg, bool bAdd, Event& evt)
     }
   }
 
-  htsmsg_t* l = htsmsg_get_map(msg, "credits");
+  htsmsg_t* l = fields.GetMap("credits");
   if (l)
   {
     std::vector<std::string> writers;
@@ -3122,7 +3377,7 @@ bool CTvheadend::ParseEvent(htsmsg_t* msg, bool bAdd, Event& evt)
     evt.SetCast(cast);
   }
 
-  l = htsmsg_get_list(msg, "category");
+  l = fields.GetList("category");
   if (l)
   {
     std::vector<std::string> categories;
@@ -3155,38 +3410,54 @@ void CTvheadend::ParseEventAddOrUpdate(htsmsg_t* msg, bool bAdd)
   sched.SetDirty(false);
 
   /* create/update event */
-  EventUids& events = sched.GetEvents();
-
   bool bUpdated = false;
-  if (bAdd && m_asyncState.GetState() == ASYNC_DONE)
+  bool bMoved = false;
+  const auto it = m_eventChannels.find(evt.GetId());
+  if (it != m_eventChannels.end())
   {
     // After a reconnect, during processing of "enableAsyncMetadata" htsp
     // method, tvheadend sends all events as "added". Check whether we
     // announced the event already and in case send it as "updated" to Kodi.
-    auto it = events.find(evt.GetId());
-    if (it != events.end())
-    {
+    if (bAdd && m_asyncState.GetState() == ASYNC_DONE)
       bUpdated = true;
 
-      Entity& ent = it->second;
-      ent.SetId(evt.GetId());
-      ent.SetDirty(false);
+    // The event moved to another channel
+    if (it->second != evt.GetChannel())
+    {
+      const auto sit = m_schedules.find(it->second);
+      if (sit != m_schedules.end())
+        sit->second.GetEvents().erase(evt.GetId());
+
+      m_epgStore.Remove(it->second, evt.GetId());
+
+      /* Kodi knows the event by channel, it is deleted there and created on the new one */
+      Event moved;
+      moved.SetId(evt.GetId());
+      moved.SetChannel(it->second);
+      PushEpgEventUpdate(moved, EPG_EVENT_DELETED);
+
+      it->second = evt.GetChannel();
+      bMoved = true;
     }
   }
-
-  if (!bUpdated)
+  else
   {
-    Entity& ent = events[evt.GetId()];
-    ent.SetId(evt.GetId());
-    ent.SetDirty(false);
+    m_eventChannels.emplace(evt.GetId(), evt.GetChannel());
   }
 
+  Entity& ent = sched.GetEvents()[evt.GetId()];
+  ent.SetId(evt.GetId());
+  ent.SetDirty(false);
+
+  m_epgStore.Add(evt);
+
   Logger::Log(LogLevel::LEVEL_TRACE, "event id:%d channel:%d start:%d stop:%d title:%s desc:%s",
               evt.GetId(), evt.GetChannel(), static_cast<int>(evt.GetStart()),
               static_cast<int>(evt.GetStop()), evt.GetTitle().c_str(), evt.GetDesc().c_str());
 
   /* Transfer event to Kodi (callback) */
-  PushEpgEventUpdate(evt, (!bAdd || bUpdated) ? EPG_EVENT_UPDATED : EPG_EVENT_CREATED);
+  PushEpgEventUpdate(evt, ((!bAdd || bUpdated) && !bMoved) ? EPG_EVENT_UPDATED
+                                                          : EPG_EVENT_CREATED);
 }
 
 void CTvheadend::ParseEventDelete(htsmsg_t* msg)
@@ -3201,27 +3472,26 @@ void CTvheadend::ParseEventDelete(htsmsg_t* msg)
   Logger::Log(LogLevel::LEVEL_TRACE, "delete event %u", u32);
 
   /* Erase */
-  for (auto& entry : m_schedules)
-  {
-    Schedule& schedule = entry.second;
-    EventUids& events = schedule.GetEvents();
+  const auto it = m_eventChannels.find(u32);
+  if (it == m_eventChannels.end())
+    return;
 
-    // Find the event so we can get the channel number
-    auto eit = events.find(u32);
+  const uint32_t channelId = it->second;
+  m_eventChannels.erase(it);
 
-    if (eit != events.end())
-    {
-      Logger::Log(LogLevel::LEVEL_TRACE, "deleted event %d from channel %d", u32, schedule.GetId());
-      events.erase(eit);
-
-      /* Transfer event to Kodi (callback) */
-      Event evt;
-      evt.SetId(u32);
-      evt.SetChannel(schedule.GetId());
-      PushEpgEventUpdate(evt, EPG_EVENT_DELETED);
-      return;
-    }
-  }
+  const auto sit = m_schedules.find(channelId);
+  if (sit != m_schedules.end())
+    sit->second.GetEvents().erase(u32);
+
+  m_epgStore.Remove(channelId, u32);
+
+  Logger::Log(LogLevel::LEVEL_TRACE, "deleted event %d from channel %d", u32, channelId);
+
+  /* Transfer event to Kodi (callback) */
+  Event evt;
+  evt.SetId(u32);
+  evt.SetChannel(channelId);
+  PushEpgEventUpdate(evt, EPG_EVENT_DELETED);
 }
 
 uint32_t CTvheadend::GetNextUnnumberedChannelNumber()
@@ -3252,7 +3522,7 @@ void CTvheadend::TuneOnOldest(uint32_t channelId)
   {
     Logger::Log(LogLevel::LEVEL_TRACE, "pretuning channel %u on subscription %u",
                 m_channels[channelId].GetNum(), oldest->GetSubscriptionId());
-    oldest->Open(channelId, SUBSCRIPTION_WEIGHT_PRETUNING);
+    oldest->OpenAsync(channelId, SUBSCRIPTION_WEIGHT_PRETUNING);
   }
 }
 
@@ -3271,13 +3541,26 @@ void CTvheadend::PredictiveTune(uint32_t fromChannelId, uint32_t toChannelId)
 
 bool CTvheadend::OpenLiveStream(const kodi::addon::PVRChannel& chn)
 {
+  const auto start = std::chrono::steady_clock::now();
+  const bool ret = OpenLiveStream0(chn);
+  Logger::Log(LogLevel::LEVEL_DEBUG, "opening channel %u took %lld ms", chn.GetUniqueId(),
+              static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - start)
+                                         .count()));
+  return ret;
+}
+
+bool CTvheadend::OpenLiveStream0(const kodi::addon::PVRChannel& chn)
+{
+  /* Only subscribing to the target channel is waited for; weight changes,
+   * unsubscribes and predictive tuning are sent without waiting for the response */
   HTSPDemuxer* oldest = m_dmx[0];
 
   if (m_dmx.size() == 1)
   {
     /* speedup things if we don't use predictive tuning */
+    SetActiveDemuxer(oldest);
     m_playingLiveStream = oldest->Open(chn.GetUniqueId(), SUBSCRIPTION_WEIGHT_SERVERCONF);
-    m_dmx_active = oldest;
     return m_playingLiveStream;
   }
 
@@ -3296,9 +3579,13 @@ bool CTvheadend::OpenLiveStream(const kodi::addon::PVRChannel& chn)
         m_dmx_active->Weight(SUBSCRIPTION_WEIGHT_POSTTUNING);
         uint32_t prevId = m_dmx_active->GetChannelId();
 
-        /* Promote the lingering subscription to the active one */
+        /* Promote the lingering subscription to the active one, starting at its last key frame */
         dmx->Weight(SUBSCRIPTION_WEIGHT_NORMAL);
-        m_dmx_active = dmx;
+        {
+          std::lock_guard<std::mutex> lock(m_dmxTrimMutex);
+          dmx->Trim();
+          SetActiveDemuxer0(dmx);
+        }
 
         PredictiveTune(prevId, chn.GetUniqueId());
         m_streamchange = true;
@@ -3320,8 +3607,9 @@ bool CTvheadend::OpenLiveStream(const kodi::addon::PVRChannel& chn)
   uint32_t prevId = m_dmx_active->GetChannelId();
   m_dmx_active->Weight(SUBSCRIPTION_WEIGHT_POSTTUNING);
 
+  /* Active before it is opened, so that its new packets are not trimmed */
+  SetActiveDemuxer(oldest);
   m_playingLiveStream = oldest->Open(chn.GetUniqueId(), SUBSCRIPTION_WEIGHT_NORMAL);
-  m_dmx_active = oldest;
   if (m_playingLiveStream)
     PredictiveTune(prevId, chn.GetUniqueId());
 
@@ -3330,28 +3618,19 @@ bool CTvheadend::OpenLiveStream(const kodi::addon::PVRChannel& chn)
 
 DEMUX_PACKET* CTvheadend::DemuxRead()
 {
-  DEMUX_PACKET* pkt = nullptr;
-
   if (m_streamchange)
   {
     /* when switching to a previously used channel, we have to trigger a stream
      * change update through kodi. We don't queue that through the dmx packet
      * buffer, as we really want to use the currently queued packets for
      * immediate playback. */
-    pkt = kodi::addon::CInstancePVRClient::AllocateDemuxPacket(0);
+    DEMUX_PACKET* pkt = kodi::addon::CInstancePVRClient::AllocateDemuxPacket(0);
     pkt->iStreamId = DEMUX_SPECIALID_STREAMCHANGE;
     m_streamchange = false;
     return pkt;
   }
 
-  for (auto* dmx : m_dmx)
-  {
-    if (dmx == m_dmx_active)
-      pkt = dmx->Read();
-    else
-      dmx->Trim();
-  }
-  return pkt;
+  return m_dmx_active->Read();
 }
 
 void CTvheadend::CloseLiveStream()
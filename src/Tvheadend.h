@@ -17,9 +17,11 @@ extern "C"
 #include "tvheadend/AutoRecordings.h"
 #include "tvheadend/ChannelTuningPredictor.h"
 #include "tvheadend/CustomTimerProperties.h"
+#include "tvheadend/EpgStore.h"
 #include "tvheadend/HTSPMessage.h"
 #include "tvheadend/IHTSPConnectionListener.h"
 #include "tvheadend/IHTSPDemuxPacketHandler.h"
+#include "tvheadend/MetadataSnapshot.h"
 #include "tvheadend/Profile.h"
 #include "tvheadend/TimeRecordings.h"
 #include "tvheadend/entity/Channel.h"
@@ -28,14 +30,18 @@ extern "C"
 #include "tvheadend/entity/Schedule.h"
 #include "tvheadend/entity/Tag.h"
 #include "tvheadend/utilities/AsyncState.h"
+#include "tvheadend/utilities/ByteBudget.h"
+#include "tvheadend/utilities/RoutingTable.h"
 #include "tvheadend/utilities/SyncedBuffer.h"
 
 #include "kodi/addon-instance/PVR.h"
 #include "kodi/tools/Thread.h"
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -78,6 +84,7 @@ public:
   void Disconnected() override;
   bool Connected(std::unique_lock<std::recursive_mutex>& lock) override;
   bool ProcessMessage(const std::string& method, htsmsg_t* msg) override;
+  void ProcessMuxPacket(const tvheadend::HTSPMuxPacket& pkt) override;
   void ConnectionStateChange(const std::string& connectionString,
                              PVR_CONNECTION_STATE newState,
                              const std::string& message) override;
@@ -131,6 +138,7 @@ public:
                              time_t end,
                              kodi::addon::PVREPGTagsResultSet& results) override;
   PVR_ERROR SetEPGMaxFutureDays(int futureDays) override;
+  PVR_ERROR SetEPGMaxPastDays(int pastDays) override;
 
   void GetLivetimeValues(std::vector<kodi::addon::PVRTypeIntValue>& lifetimeValues) const;
 
@@ -150,6 +158,12 @@ private:
    */
   void QueryAvailableProfiles(std::unique_lock<std::recursive_mutex>& lock);
 
+  /**
+   * Queries the server for its current time
+   * @return the server time, 0 on failure
+   */
+  int64_t QueryServerTime(std::unique_lock<std::recursive_mutex>& lock);
+
   /**
    * @param streamingProfile the streaming profile to check for
    * @return whether the server supports the specified streaming profile
@@ -161,6 +175,7 @@ private:
    */
   void PredictiveTune(uint32_t fromChannelId, uint32_t toChannelId);
   void TuneOnOldest(uint32_t channelId);
+  bool OpenLiveStream0(const kodi::addon::PVRChannel& chn);
 
   /*
    * Message processing (CThread implementation)
@@ -199,6 +214,12 @@ private:
   void SyncDvrCompleted();
   void SyncEpgCompleted();
   void SyncCompleted();
+
+  /**
+   * Waits until the channel list is available, either from the snapshot or from the server
+   * @return false if the channel list is not available
+   */
+  bool WaitForChannelList();
   void ParseTagAddOrUpdate(htsmsg_t* m, bool bAdd);
   void ParseTagDelete(htsmsg_t* m);
   void ParseChannelAddOrUpdate(htsmsg_t* m, bool bAdd);
@@ -242,6 +263,13 @@ public:
   bool IsRealTimeStream() override;
 
   void CloseExpiredSubscriptions();
+  void TrimStandbyDemuxers();
+
+  /**
+   * Makes the demuxer the active one, it is no longer trimmed from then on
+   */
+  void SetActiveDemuxer(tvheadend::HTSPDemuxer* dmx);
+  void SetActiveDemuxer0(tvheadend::HTSPDemuxer* dmx); // m_dmxTrimMutex must be held
 
   /*
    * VFS
@@ -279,8 +307,19 @@ public:
 
   const tvheadend::CustomTimerProperties m_customTimerProps;
 
+  /**
+   * The budget for the packets buffered by all demuxers
+   */
+  tvheadend::utilities::ByteBudget m_dmxBudget;
+
+  /**
+   * The demuxers by their current subscription id
+   */
+  tvheadend::utilities::RoutingTable<tvheadend::HTSPDemuxer> m_dmxRoutes;
   std::vector<tvheadend::HTSPDemuxer*> m_dmx;
   tvheadend::HTSPDemuxer* m_dmx_active;
+  std::mutex m_dmxTrimMutex; // serializes trimming of standby demuxers and their promotion
+  time_t m_lastDmxTrim{0};
   bool m_streamchange;
   std::map<uint32_t, std::shared_ptr<tvheadend::HTSPVFS>> m_vfs;
   bool m_stateRebuilt{false};
@@ -292,10 +331,13 @@ public:
   tvheadend::entity::Tags m_tags;
   tvheadend::entity::Recordings m_recordings;
   tvheadend::entity::Schedules m_schedules;
+  std::unordered_map<uint32_t, uint32_t> m_eventChannels; // channel id of each scheduled event
+  tvheadend::EpgStore m_epgStore;
 
   tvheadend::ChannelTuningPredictor m_channelTuningPredictor;
 
   tvheadend::SHTSPEventList m_events;
+  tvheadend::SHTSPEventIndex m_epgEvents; // pending EPG updates in m_events
 
   tvheadend::utilities::AsyncState m_asyncState;
 
@@ -304,5 +346,27 @@ public:
 
   int m_epgMaxDays;
 
+  /*
+   * Channel list of the last session, served until the initial sync completed
+   */
+  tvheadend::MetadataSnapshot m_snapshot;
+  std::atomic<bool> m_snapshotLoaded{false};
+
+  /*
+   * Incremental metadata sync: the server time up to which all EPG updates have been received
+   * and the EPG window they cover; the pending values become valid once a sync completed
+   */
+  int64_t m_syncLastUpdate{0};
+  int64_t m_syncEpgMaxTime{0};
+  int64_t m_pendingLastUpdate{0};
+  int64_t m_pendingEpgMaxTime{0};
+
+  /*
+   * Whether the current sync resends all events and thereby sweeps the EPG store. Incremental
+   * syncs do not resend the events deleted while disconnected, the channels are swept one by one
+   * by getEvents then.
+   */
+  bool m_pendingEpgStoreSwept{false};
+
   bool m_playingLiveStream;
 };
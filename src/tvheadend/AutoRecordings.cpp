@@ -9,6 +9,7 @@
 
 #include "CustomTimerProperties.h"
 #include "HTSPConnection.h"
+#include "HTSPSchema.h"
 #include "InstanceSettings.h"
 #include "entity/Recording.h"
 #include "utilities/LifetimeMapper.h"
@@ -328,10 +329,23 @@ PVR_ERROR AutoRecordings::SendAutorecDelete(const kodi::addon::PVRTimer& timer)
   return u32 == 1 ? PVR_ERROR_NO_ERROR : PVR_ERROR_FAILED;
 }
 
+namespace
+{
+
+/* autorecEntryAdd/autorecEntryUpdate */
+constexpr HTSPSchema AUTOREC_SCHEMA({"id", "enabled", "removal", "daysOfWeek", "priority", "start",
+                                     "startWindow", "startExtra", "stopExtra", "dupDetect", "title",
+                                     "name", "directory", "owner", "creator", "channel", "fulltext",
+                                     "serieslinkUri", "broadcastType", "configId", "comment"});
+
+} // unnamed namespace
+
 bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
 {
+  const HTSPFields fields(AUTOREC_SCHEMA, msg);
+
   /* Validate/set mandatory fields */
-  const char* str = htsmsg_get_str(msg, "id");
+  const char* str = fields.GetStr("id");
   if (!str)
   {
     Logger::Log(LogLevel::LEVEL_ERROR,
@@ -348,7 +362,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   /* Validate/set fields mandatory for autorecEntryAdd */
 
   uint32_t u32 = 0;
-  if (!htsmsg_get_u32(msg, "enabled", &u32))
+  if (!fields.GetU32("enabled", &u32))
   {
     rec.SetEnabled(u32);
   }
@@ -358,7 +372,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "removal", &u32))
+  if (!fields.GetU32("removal", &u32))
   {
     rec.SetLifetime(u32);
   }
@@ -368,7 +382,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "daysOfWeek", &u32))
+  if (!fields.GetU32("daysOfWeek", &u32))
   {
     rec.SetDaysOfWeek(u32);
   }
@@ -378,7 +392,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "priority", &u32))
+  if (!fields.GetU32("priority", &u32))
   {
     rec.SetPriority(u32);
   }
@@ -389,7 +403,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   int32_t s32 = 0;
-  if (!htsmsg_get_s32(msg, "start", &s32))
+  if (!fields.GetS32("start", &s32))
   {
     rec.SetStartWindowBegin(s32);
   }
@@ -399,7 +413,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_s32(msg, "startWindow", &s32))
+  if (!fields.GetS32("startWindow", &s32))
   {
     rec.SetStartWindowEnd(s32);
   }
@@ -410,7 +424,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   int64_t s64 = 0;
-  if (!htsmsg_get_s64(msg, "startExtra", &s64))
+  if (!fields.GetS64("startExtra", &s64))
   {
     rec.SetMarginStart(s64);
   }
@@ -420,7 +434,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_s64(msg, "stopExtra", &s64))
+  if (!fields.GetS64("stopExtra", &s64))
   {
     rec.SetMarginEnd(s64);
   }
@@ -430,7 +444,7 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "dupDetect", &u32))
+  if (!fields.GetU32("dupDetect", &u32))
   {
     rec.SetDupDetect(u32);
   }
@@ -441,46 +455,46 @@ bool AutoRecordings::ParseAutorecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   /* Add optional fields */
-  str = htsmsg_get_str(msg, "title");
+  str = fields.GetStr("title");
   if (str)
     rec.SetTitle(str);
 
-  str = htsmsg_get_str(msg, "name");
+  str = fields.GetStr("name");
   if (str)
     rec.SetName(str);
 
-  str = htsmsg_get_str(msg, "directory");
+  str = fields.GetStr("directory");
   if (str)
     rec.SetDirectory(str);
 
-  str = htsmsg_get_str(msg, "owner");
+  str = fields.GetStr("owner");
   if (str)
     rec.SetOwner(str);
 
-  str = htsmsg_get_str(msg, "creator");
+  str = fields.GetStr("creator");
   if (str)
     rec.SetCreator(str);
 
-  if (!htsmsg_get_u32(msg, "channel", &u32))
+  if (!fields.GetU32("channel", &u32))
     rec.SetChannel(u32);
   else
     rec.SetChannel(PVR_TIMER_ANY_CHANNEL); // an empty channel field = any channel
 
-  if (!htsmsg_get_u32(msg, "fulltext", &u32))
+  if (!fields.GetU32("fulltext", &u32))
     rec.SetFulltext(u32);
 
-  str = htsmsg_get_str(msg, "serieslinkUri");
+  str = fields.GetStr("serieslinkUri");
   if (str)
     rec.SetSeriesLink(str);
 
-  if (!htsmsg_get_u32(msg, "broadcastType", &u32))
+  if (!fields.GetU32("broadcastType", &u32))
     rec.SetBroadcastType(u32);
 
-  str = htsmsg_get_str(msg, "configId");
+  str = fields.GetStr("configId");
   if (str)
     rec.SetConfigUuid(str);
 
-  str = htsmsg_get_str(msg, "comment");
+  str = fields.GetStr("comment");
   if (str)
     rec.SetComment(str);
 
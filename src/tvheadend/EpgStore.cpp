@@ -0,0 +1,322 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "EpgStore.h"
+
+#include "utilities/Logger.h"
+
+#include <algorithm>
+
+using namespace tvheadend;
+using namespace tvheadend::entity;
+using namespace tvheadend::utilities;
+
+EpgStore::EpgStore(size_t maxSize) : m_maxSize(maxSize)
+{
+}
+
+void EpgStore::Add(const Event& event)
+{
+  if (m_overflow)
+    return;
+
+  Records& records = m_channels[event.GetChannel()];
+
+  auto it = std::find_if(records.begin(), records.end(),
+                         [&event](const Record& record) { return record.id == event.GetId(); });
+  if (it != records.end())
+  {
+    RemoveRecord(*it);
+    records.erase(it);
+  }
+
+  Record record = CreateRecord(event);
+  it = std::upper_bound(records.begin(), records.end(), record,
+                        [](const Record& left, const Record& right)
+                        { return left.start < right.start; });
+  ++m_eventCount;
+  m_textBytes += GetTextMemoryUsage(record);
+  records.insert(it, std::move(record));
+
+  if (GetMemoryUsage() <= m_maxSize)
+    return;
+
+  /* Drop the events Kodi no longer asks for */
+  if (m_maxPastDays >= 0)
+  {
+    m_trimmedBefore = std::time(nullptr) - m_maxPastDays * time_t(24 * 60 * 60);
+    RemoveBefore(m_trimmedBefore);
+  }
+
+  if (GetMemoryUsage() > m_maxSize)
+  {
+    Logger::Log(LogLevel::LEVEL_WARNING,
+                "epg store exceeds %zu bytes with %zu events, falling back to server queries",
+                m_maxSize, m_eventCount);
+    Clear();
+    m_overflow = true;
+  }
+}
+
+void EpgStore::Remove(uint32_t channelId, uint32_t eventId)
+{
+  const auto cit = m_channels.find(channelId);
+  if (cit == m_channels.end())
+    return;
+
+  Records& records = cit->second;
+  const auto it = std::find_if(records.begin(), records.end(), [eventId](const Record& record)
+                               { return record.id == eventId; });
+  if (it == records.end())
+    return;
+
+  RemoveRecord(*it);
+  records.erase(it);
+
+  if (records.empty())
+    m_channels.erase(cit);
+}
+
+void EpgStore::Clear()
+{
+  m_channels.clear();
+  m_eventCount = 0;
+  m_textBytes = 0;
+  m_overflow = false;
+  m_trimmedBefore = 0;
+  ResetSwept();
+}
+
+void EpgStore::Sweep(uint32_t channelId,
+                     time_t start,
+                     time_t end,
+                     const std::vector<Event>& events)
+{
+  if (m_overflow)
+    return;
+
+  const auto cit = m_channels.find(channelId);
+  if (cit != m_channels.end())
+  {
+    Records& records = cit->second;
+    const auto last = std::remove_if(
+        records.begin(), records.end(),
+        [this, start, end, &events](const Record& record)
+        {
+          if (record.stop <= start || record.start >= end ||
+              std::any_of(events.begin(), events.end(),
+                          [&record](const Event& event) { return event.GetId() == record.id; }))
+            return false;
+
+          RemoveRecord(record);
+          return true;
+        });
+    records.erase(last, records.end());
+
+    if (records.empty())
+      m_channels.erase(cit);
+  }
+
+  for (const auto& event : events)
+    Add(event);
+
+  if (!m_overflow)
+    m_channelsSweptUntil[channelId] = end;
+}
+
+void EpgStore::SetSwept(time_t end)
+{
+  m_sweptUntil = end;
+  m_channelsSweptUntil.clear();
+}
+
+void EpgStore::ResetSwept()
+{
+  m_sweptUntil = 0;
+  m_channelsSweptUntil.clear();
+}
+
+bool EpgStore::IsComplete(uint32_t channelId, time_t start, time_t end) const
+{
+  if (m_overflow || start < m_trimmedBefore)
+    return false;
+
+  if (end <= m_sweptUntil)
+    return true;
+
+  const auto it = m_channelsSweptUntil.find(channelId);
+  return it != m_channelsSweptUntil.end() && end <= it->second;
+}
+
+void EpgStore::GetEvents(uint32_t channelId,
+                         time_t start,
+                         time_t end,
+                         std::vector<Event>& events) const
+{
+  const auto cit = m_channels.find(channelId);
+  if (cit == m_channels.end())
+    return;
+
+  for (const auto& record : cit->second)
+  {
+    if (record.start >= end)
+      break;
+
+    if (record.stop > start)
+      events.emplace_back(CreateEvent(channelId, record));
+  }
+}
+
+size_t EpgStore::GetMemoryUsage() const
+{
+  /* The interned strings are shared with other events and entities, they are not counted */
+  return m_eventCount * sizeof(Record) + m_channels.size() * (sizeof(Records) + 32) + m_textBytes;
+}
+
+void EpgStore::LogMemoryUsage() const
+{
+  const size_t bytes = GetMemoryUsage();
+  Logger::Log(LogLevel::LEVEL_INFO,
+              "epg store: %zu events on %zu channels, %zu bytes of text, %zu bytes "
+              "(%zu per event)",
+              m_eventCount, m_channels.size(), m_textBytes, bytes,
+              m_eventCount ? bytes / m_eventCount : 0);
+}
+
+EpgStore::Record EpgStore::CreateRecord(const Event& event)
+{
+  Record record;
+  record.start = event.GetStart();
+  record.stop = event.GetStop();
+  record.id = event.GetId();
+  record.content = event.GetContent();
+  record.stars = event.GetStars();
+  record.age = event.GetAge();
+  record.season = event.GetSeason();
+  record.episode = event.GetEpisode();
+  record.part = event.GetPart();
+  record.recordingId = event.GetRecordingId();
+  record.year = event.GetYear();
+
+  record.shared[TITLE] = event.GetTitle();
+  record.shared[SERIES_LINK] = event.GetSeriesLink();
+  record.shared[WRITERS] = event.GetWriters();
+  record.shared[DIRECTORS] = event.GetDirectors();
+  record.shared[CAST] = event.GetCast();
+  record.shared[CATEGORIES] = event.GetCategories();
+  record.shared[AIRED] = event.GetAired();
+  record.shared[RATING_LABEL] = event.GetRatingLabel();
+  record.shared[RATING_ICON] = event.GetRatingIcon();
+  record.shared[RATING_SOURCE] = event.GetRatingSource();
+
+  const std::string* text[TEXT_FIELDS];
+  text[SUBTITLE] = &event.GetSubtitle();
+  text[DESCRIPTION] = &event.GetDesc();
+  text[SUMMARY] = &event.GetSummary();
+  text[IMAGE] = &event.GetImage();
+
+  size_t size = 0;
+  for (int i = 0; i < TEXT_FIELDS; ++i)
+  {
+    record.textLength[i] = static_cast<uint32_t>(text[i]->size());
+    size += text[i]->size();
+  }
+
+  if (size > 0)
+  {
+    record.text.reset(new char[size]);
+    char* pos = record.text.get();
+    for (const std::string* str : text)
+      pos = std::copy(str->begin(), str->end(), pos);
+  }
+
+  return record;
+}
+
+Event EpgStore::CreateEvent(uint32_t channelId, const Record& record) const
+{
+  Event event;
+  event.SetId(record.id);
+  event.SetChannel(channelId);
+  event.SetStart(static_cast<time_t>(record.start));
+  event.SetStop(static_cast<time_t>(record.stop));
+  event.SetContent(record.content);
+  event.SetStars(record.stars);
+  event.SetAge(record.age);
+  event.SetSeason(record.season);
+  event.SetEpisode(record.episode);
+  event.SetPart(record.part);
+  event.SetRecordingId(record.recordingId);
+  event.SetYear(record.year);
+
+  event.SetTitle(record.shared[TITLE]);
+  event.SetSubtitle(GetText(record, SUBTITLE));
+  event.SetDesc(GetText(record, DESCRIPTION));
+  event.SetSummary(GetText(record, SUMMARY));
+  event.SetImage(GetText(record, IMAGE));
+  event.SetSeriesLink(record.shared[SERIES_LINK]);
+  event.SetWriters(record.shared[WRITERS]);
+  event.SetDirectors(record.shared[DIRECTORS]);
+  event.SetCast(record.shared[CAST]);
+  event.SetCategories(record.shared[CATEGORIES]);
+  event.SetAired(record.shared[AIRED]);
+  event.SetRatingLabel(record.shared[RATING_LABEL]);
+  event.SetRatingIcon(record.shared[RATING_ICON]);
+  event.SetRatingSource(record.shared[RATING_SOURCE]);
+  return event;
+}
+
+void EpgStore::RemoveRecord(const Record& record)
+{
+  --m_eventCount;
+  m_textBytes -= GetTextMemoryUsage(record);
+}
+
+void EpgStore::RemoveBefore(time_t time)
+{
+  for (auto it = m_channels.begin(); it != m_channels.end();)
+  {
+    Records& records = it->second;
+    const auto end = std::remove_if(records.begin(), records.end(),
+                                    [this, time](const Record& record)
+                                    {
+                                      if (record.stop >= time)
+                                        return false;
+
+                                      RemoveRecord(record);
+                                      return true;
+                                    });
+    records.erase(end, records.end());
+
+    if (records.empty())
+      it = m_channels.erase(it);
+    else
+      ++it;
+  }
+}
+
+std::string EpgStore::GetText(const Record& record, TextField field)
+{
+  size_t offset = 0;
+  for (int i = 0; i < field; ++i)
+    offset += record.textLength[i];
+
+  if (record.textLength[field] == 0)
+    return std::string();
+
+  return std::string(record.text.get() + offset, record.textLength[field]);
+}
+
+size_t EpgStore::GetTextMemoryUsage(const Record& record)
+{
+  size_t size = 0;
+  for (uint32_t length : record.textLength)
+    size += length;
+
+  /* The allocation and its overhead */
+  return size > 0 ? size + 2 * sizeof(void*) : 0;
+}
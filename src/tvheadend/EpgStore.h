@@ -0,0 +1,174 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "entity/Event.h"
+#include "utilities/InternedString.h"
+
+#include <ctime>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tvheadend
+{
+
+/*
+ * Local copy of the events received by the async EPG sync. Events are kept per channel as compact
+ * records, sorted by start time, with the strings that repeat across events interned. The store is
+ * bounded: events that ended before Kodi's EPG past days are dropped first, and once it grows
+ * beyond its maximum size without any such events left to drop, it gives up and stays empty until
+ * it is cleared.
+ *
+ * A channel's events are only complete once they were swept, i.e. checked against a complete list
+ * of the channel's events: a full sync sweeps all channels, a getEvents answer a single channel.
+ */
+class EpgStore
+{
+public:
+  /**
+   * @param maxSize the maximum number of bytes to use
+   */
+  EpgStore(size_t maxSize);
+
+  /**
+   * Adds an event or replaces the event with the same id on the same channel
+   */
+  void Add(const entity::Event& event);
+
+  void Remove(uint32_t channelId, uint32_t eventId);
+
+  /**
+   * Removes all events and leaves the overflow state
+   */
+  void Clear();
+
+  /**
+   * @param days the number of days Kodi keeps past events, negative for unlimited
+   */
+  void SetMaxPastDays(int days) { m_maxPastDays = days; }
+
+  /**
+   * Replaces the events of a channel within a time range
+   * @param channelId the channel
+   * @param start the start of the time range
+   * @param end the end of the time range
+   * @param events all events of the channel overlapping the time range
+   */
+  void Sweep(uint32_t channelId,
+             time_t start,
+             time_t end,
+             const std::vector<entity::Event>& events);
+
+  /**
+   * Marks the events of all channels as swept, e.g. after a full sync
+   * @param end the end of the time range the events were received for
+   */
+  void SetSwept(time_t end);
+
+  /**
+   * Marks the events of all channels as not swept, e.g. while incremental updates are received
+   */
+  void ResetSwept();
+
+  /**
+   * @param channelId the channel
+   * @param start the start of the time range
+   * @param end the end of the time range
+   * @return true if the store holds all events of the channel overlapping the time range
+   */
+  bool IsComplete(uint32_t channelId, time_t start, time_t end) const;
+
+  /**
+   * @param channelId the channel
+   * @param start the start of the time range
+   * @param end the end of the time range
+   * @param events receives the events of the channel overlapping the time range
+   */
+  void GetEvents(uint32_t channelId,
+                 time_t start,
+                 time_t end,
+                 std::vector<entity::Event>& events) const;
+
+  size_t GetEventCount() const { return m_eventCount; }
+
+  /**
+   * @return the approximate number of bytes used by the store
+   */
+  size_t GetMemoryUsage() const;
+
+  void LogMemoryUsage() const;
+
+private:
+  /* Fields that repeat across events, interned */
+  enum SharedField
+  {
+    TITLE,
+    SERIES_LINK,
+    WRITERS,
+    DIRECTORS,
+    CAST,
+    CATEGORIES,
+    AIRED,
+    RATING_LABEL,
+    RATING_ICON,
+    RATING_SOURCE,
+    SHARED_FIELDS
+  };
+
+  /* Fields unique to an event, stored one after another in a single allocation */
+  enum TextField
+  {
+    SUBTITLE,
+    DESCRIPTION,
+    SUMMARY,
+    IMAGE,
+    TEXT_FIELDS
+  };
+
+  struct Record
+  {
+    int64_t start;
+    int64_t stop;
+    uint32_t id;
+    uint32_t content;
+    uint32_t stars;
+    uint32_t age;
+    int32_t season;
+    int32_t episode;
+    int32_t part;
+    uint32_t recordingId;
+    uint32_t year;
+    uint32_t textLength[TEXT_FIELDS];
+    std::unique_ptr<char[]> text;
+    utilities::InternedString shared[SHARED_FIELDS];
+  };
+
+  typedef std::vector<Record> Records;
+
+  Record CreateRecord(const entity::Event& event);
+  entity::Event CreateEvent(uint32_t channelId, const Record& record) const;
+  void RemoveRecord(const Record& record);
+  void RemoveBefore(time_t time);
+
+  static std::string GetText(const Record& record, TextField field);
+  static size_t GetTextMemoryUsage(const Record& record);
+
+  const size_t m_maxSize;
+  std::unordered_map<uint32_t, Records> m_channels;
+  size_t m_eventCount = 0;
+  size_t m_textBytes = 0;
+  bool m_overflow = false;
+  int m_maxPastDays = -1;
+  time_t m_trimmedBefore = 0; // events ending before this time were dropped
+  time_t m_sweptUntil = 0; // all channels are swept up to this time
+  std::unordered_map<uint32_t, time_t> m_channelsSweptUntil; // swept since, up to this time
+};
+
+} // namespace tvheadend
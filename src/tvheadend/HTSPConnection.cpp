@@ -13,6 +13,7 @@ extern "C"
 #include "libhts/sha1.h"
 }
 
+#include "HTSPMuxPacket.h"
 #include "IHTSPConnectionListener.h"
 #include "InstanceSettings.h"
 #include "utilities/Logger.h"
@@ -24,6 +25,7 @@ extern "C"
 
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
 
 using namespace tvheadend;
 using namespace tvheadend::utilities;
@@ -58,9 +60,14 @@ public:
     Set(nullptr); // ensure signal is sent
   }
 
-  htsmsg_t* Get(std::unique_lock<std::recursive_mutex>& lock, uint32_t timeout)
+  bool Wait(std::unique_lock<std::recursive_mutex>& lock, uint32_t timeout)
+  {
+    return m_cond.wait_for(lock, std::chrono::milliseconds(timeout),
+                           [this] { return m_flag == true; });
+  }
+
+  htsmsg_t* Release()
   {
-    m_cond.wait_for(lock, std::chrono::milliseconds(timeout), [this] { return m_flag == true; });
     htsmsg_t* r = m_msg;
     m_msg = nullptr;
     m_flag = false;
@@ -102,6 +109,7 @@ HTSPConnection::HTSPConnection(const std::shared_ptr<InstanceSettings>& settings
     m_suspended(false),
     m_state(PVR_CONNECTION_STATE_UNKNOWN)
 {
+  UpdateWebBaseURL();
 }
 
 HTSPConnection::~HTSPConnection()
@@ -153,9 +161,62 @@ bool IsIPv6NumericHost(const std::string& str)
   return ret;
 }
 
+/*
+ * Requests known to take longer than usual on the server, e.g. getEvents for a channel with a
+ * large EPG or deleting a recording on a busy disk
+ */
+struct MethodTimeout
+{
+  const char* method;
+  int factor; // multiple of the configured response timeout
+};
+
+const MethodTimeout METHOD_TIMEOUTS[] = {
+    {"getEvents", 4},      {"epgQuery", 4},   {"deleteDvrEntry", 4}, {"stopDvrEntry", 2},
+    {"cancelDvrEntry", 2}, {"addDvrEntry", 2}, {"getDiskSpace", 2},   {"fileOpen", 2},
+    {"fileSeek", 2},
+};
+
+int GetMethodTimeoutFactor(const char* method)
+{
+  for (const auto& entry : METHOD_TIMEOUTS)
+  {
+    if (!std::strcmp(entry.method, method))
+      return entry.factor;
+  }
+  return 1;
+}
+
+/*
+ * Check result for errors and announce. Returns nullptr (and destroys msg) on error.
+ */
+htsmsg_t* CheckResponse(const char* method, htsmsg_t* msg)
+{
+  uint32_t noaccess = 0;
+  if (!htsmsg_get_u32(msg, "noaccess", &noaccess) && noaccess)
+  {
+    // access denied
+    Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: Access denied", method);
+    htsmsg_destroy(msg);
+    return nullptr;
+  }
+  else
+  {
+    const char* strError = htsmsg_get_str(msg, "error");
+    if (strError)
+    {
+      Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: %s", method, strError);
+      htsmsg_destroy(msg);
+      return nullptr;
+    }
+  }
+
+  return msg;
+}
+
 } // unnamed namespace
 
-std::string HTSPConnection::GetWebURL(const char* fmt, ...) const
+void HTSPConnection::UpdateWebBaseURL()
 {
   // Generate the authentication string (user:pass@)
   std::string auth = m_settings->GetUsername();
@@ -170,13 +231,31 @@ std::string HTSPConnection::GetWebURL(const char* fmt, ...) const
       "%s://%s%s%s%s:%d", proto, auth.c_str(), isIPv6 ? "[" : "", m_settings->GetHostname().c_str(),
       isIPv6 ? "]" : "", m_settings->GetPortHTTP());
 
-  va_list va;
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  m_webBaseURL = url + m_webRoot;
+}
+
+std::string HTSPConnection::GetWebURL(const char* path) const
+{
+  const size_t len = std::strlen(path);
+  std::string url;
+
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  url.reserve(m_webBaseURL.size() + len + 1);
+  url += m_webBaseURL;
+  if (*path != '/')
+    url += '/';
+  url.append(path, len);
+
+  return url;
+}
 
+std::string HTSPConnection::GetWebPath(const std::string& url) const
+{
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
-  va_start(va, fmt);
-  url += m_webRoot;
-  url += kodi::tools::StringUtils::FormatV(fmt, va);
-  va_end(va);
+  const size_t len = m_webBaseURL.size();
+  if (url.size() > len && url[len] == '/' && url.compare(0, len, m_webBaseURL) == 0)
+    return url.substr(len);
 
   return url;
 }
@@ -192,12 +271,24 @@ bool HTSPConnection::WaitForConnection(std::unique_lock<std::recursive_mutex>& l
   return m_ready;
 }
 
+uint32_t HTSPConnection::GetReconnectCount() const
+{
+  const uint32_t connections = m_connections;
+  return connections > 0 ? connections - 1 : 0;
+}
+
 int HTSPConnection::GetProtocol() const
 {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
   return m_htspVersion;
 }
 
+bool HTSPConnection::IsReady() const
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  return m_ready;
+}
+
 std::string HTSPConnection::GetServerName() const
 {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
@@ -288,7 +379,10 @@ void HTSPConnection::Disconnect()
   }
 
   /* Signal all waiters and erase messages */
-  m_messages.clear();
+  HTSPResponseList pending;
+  pending.swap(m_messages);
+  for (auto& entry : pending)
+    entry.second.handler(nullptr);
 }
 
 /*
@@ -299,33 +393,34 @@ void HTSPConnection::Disconnect()
 bool HTSPConnection::ReadMessage()
 {
   /* Read 4 byte len */
-  uint8_t lb[4];
-  size_t len = m_socket->Read(&lb, sizeof(lb));
-  if (len != sizeof(lb))
+  if (!m_rxBuffer.Fill(*m_socket, 4))
     return false;
 
-  len = (lb[0] << 24) + (lb[1] << 16) + (lb[2] << 8) + lb[3];
+  const uint8_t* lb = m_rxBuffer.Data();
+  size_t len = (lb[0] << 24) + (lb[1] << 16) + (lb[2] << 8) + lb[3];
 
-  /* Read rest of packet */
-  uint8_t* buf = static_cast<uint8_t*>(malloc(len));
-  size_t cnt = 0;
-  while (cnt < len)
+  /* Read rest of packet (usually already buffered) */
+  if (!m_rxBuffer.Fill(*m_socket, 4 + len, m_settings->GetResponseTimeout()))
   {
-    int64_t r = m_socket->Read(buf + cnt, len - cnt, m_settings->GetResponseTimeout());
-    if (r < 0)
-    {
-      Logger::Log(LogLevel::LEVEL_ERROR, "failed to read packet from socket");
-      free(buf);
-      return false;
-    }
-    cnt += r;
+    Logger::Log(LogLevel::LEVEL_ERROR, "failed to read packet from socket");
+    return false;
+  }
+
+  /* Stream packets take a fast path, straight out of the receive buffer */
+  HTSPMuxPacket muxpkt;
+  if (DecodeMuxPacket(m_rxBuffer.Data() + 4, len, muxpkt))
+  {
+    Logger::Log(LogLevel::LEVEL_TRACE, "receive message [muxpkt]");
+    m_connListener.ProcessMuxPacket(muxpkt);
+    m_rxBuffer.Consume(4 + len);
+    return true;
   }
 
-  /* Deserialize */
-  htsmsg_t* msg = htsmsg_binary_deserialize(buf, len, buf);
+  /* Deserialize (the message is placed in a single allocation, so the buffer can be reused) */
+  htsmsg_t* msg = htsmsg_binary_deserialize_arena(m_rxBuffer.Data() + 4, len);
+  m_rxBuffer.Consume(4 + len);
   if (!msg)
   {
-    /* Do not free buf here. Already done by htsmsg_binary_deserialize. */
     Logger::Log(LogLevel::LEVEL_ERROR, "failed to decode message");
     return false;
   }
@@ -335,13 +430,28 @@ bool HTSPConnection::ReadMessage()
   if (htsmsg_get_u32(msg, "seq", &seq) == 0)
   {
     Logger::Log(LogLevel::LEVEL_TRACE, "received response [%d]", seq);
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-    HTSPResponseList::iterator it = m_messages.find(seq);
-    if (it != m_messages.end())
+    HTSPPendingRequest request;
+    {
+      std::lock_guard<std::recursive_mutex> lock(m_mutex);
+      HTSPResponseList::iterator it = m_messages.find(seq);
+      if (it != m_messages.end())
+      {
+        request = std::move(it->second);
+        m_messages.erase(it);
+      }
+    }
+
+    /* Complete outside the lock, so other requests can be sent meanwhile */
+    if (request.handler)
     {
-      it->second->Set(msg);
+      request.handler(CheckResponse(request.method.c_str(), msg));
       return true;
     }
+
+    /* Response to a request that timed out or was cancelled */
+    Logger::Log(LogLevel::LEVEL_DEBUG, "dropping late response [%d]", seq);
+    htsmsg_destroy(msg);
+    return true;
   }
 
   /* Get method */
@@ -388,9 +498,14 @@ bool HTSPConnection::SendMessage0(const char* method, htsmsg_t* msg)
     return false;
 
   /* Send data */
-  int64_t c = m_socket->Write(buf, len);
+  bool ret = WriteMessage(method, buf, len);
   free(buf);
+  return ret;
+}
 
+bool HTSPConnection::WriteMessage(const char* method, const void* buf, size_t len)
+{
+  int64_t c = m_socket->Write(const_cast<void*>(buf), len);
   if (c != static_cast<int64_t>(len))
   {
     Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: failed to write to socket", method);
@@ -404,64 +519,250 @@ bool HTSPConnection::SendMessage0(const char* method, htsmsg_t* msg)
 }
 
 /*
- * Send a message and wait for response
+ * Register a request, its handler is invoked when the response arrives
  */
-htsmsg_t* HTSPConnection::SendAndWait0(std::unique_lock<std::recursive_mutex>& lock,
-                                       const char* method,
-                                       htsmsg_t* msg,
-                                       int iResponseTimeout)
+uint32_t HTSPConnection::AddRequest(const char* method, HTSPResponseHandler handler)
 {
-  if (iResponseTimeout == -1)
-    iResponseTimeout = m_settings->GetResponseTimeout();
+  uint32_t seq = ++m_seq;
+  m_messages[seq] = {method, std::move(handler)};
+  return seq;
+}
+
+/*
+ * Complete a pending request with failure
+ */
+void HTSPConnection::FailRequest(uint32_t seq)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  /* Handler already invoked if the connection was closed */
+  HTSPResponseList::iterator it = m_messages.find(seq);
+  if (it != m_messages.end())
+  {
+    HTSPResponseHandler failed = std::move(it->second.handler);
+    m_messages.erase(it);
+    failed(nullptr);
+  }
+}
+
+void HTSPConnection::Cancel(uint32_t seq)
+{
+  Logger::Log(LogLevel::LEVEL_TRACE, "cancelling request [%d]", seq);
+  FailRequest(seq);
+}
+
+/*
+ * Send a message, response is passed to the handler
+ */
+uint32_t HTSPConnection::SendAsync(const char* method, htsmsg_t* msg, HTSPResponseHandler handler)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  /* A write while (re)connecting would fail, or reach the server before authentication */
+  if (!m_ready)
+  {
+    Logger::Log(LogLevel::LEVEL_DEBUG, "Command %s not sent: not connected", method);
+    htsmsg_destroy(msg);
+    handler(nullptr);
+    return 0;
+  }
+
+  return SendAsync0(method, msg, std::move(handler));
+}
+
+uint32_t HTSPConnection::SendAsync(const char* method,
+                                   std::initializer_list<HTSPField> fields,
+                                   HTSPResponseHandler handler)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  if (!m_ready)
+  {
+    Logger::Log(LogLevel::LEVEL_DEBUG, "Command %s not sent: not connected", method);
+    handler(nullptr);
+    return 0;
+  }
+
+  return SendAsync0(method, fields, std::move(handler));
+}
+
+uint32_t HTSPConnection::SendAsync0(const char* method, htsmsg_t* msg, HTSPResponseHandler handler)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
   /* Add Sequence number */
-  uint32_t seq = ++m_seq;
+  uint32_t seq = AddRequest(method, std::move(handler));
   htsmsg_add_u32(msg, "seq", seq);
 
-  HTSPResponse resp;
-  m_messages[seq] = &resp;
-
   /* Send Message (bypass TX check) */
   if (!SendMessage0(method, msg))
   {
-    m_messages.erase(seq);
     Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: failed to transmit", method);
-    return nullptr;
+    FailRequest(seq);
+    return 0;
+  }
+
+  return seq;
+}
+
+uint32_t HTSPConnection::SendAsync0(const char* method,
+                                    std::initializer_list<HTSPField> fields,
+                                    HTSPResponseHandler handler)
+{
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  uint32_t seq = AddRequest(method, std::move(handler));
+  Logger::Log(LogLevel::LEVEL_TRACE, "sending message [%s : %d]", method, seq);
+
+  /* Encode (same field order as SendMessage0) */
+  HTSPMessageBuilder builder(m_txBuffer);
+  for (const HTSPField& field : fields)
+    builder.Add(field);
+  builder.AddS64("seq", seq);
+  builder.AddStr("method", method);
+  const std::vector<uint8_t>& buf = builder.Finish();
+
+  /* Send Message (bypass TX check) */
+  if (!WriteMessage(method, buf.data(), buf.size()))
+  {
+    Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: failed to transmit", method);
+    FailRequest(seq);
+    return 0;
   }
 
+  return seq;
+}
+
+/*
+ * Wait for the response of a request sent by the given function
+ */
+htsmsg_t* HTSPConnection::WaitForResponse(std::unique_lock<std::recursive_mutex>& lock,
+                                          const char* method,
+                                          int iResponseTimeout,
+                                          const std::function<uint32_t(HTSPResponseHandler)>& send)
+{
+  if (iResponseTimeout == -1)
+    iResponseTimeout = m_settings->GetResponseTimeout() * GetMethodTimeoutFactor(method);
+
+  const uint64_t bytesRead = m_rxBuffer.GetBytesRead();
+  const std::shared_ptr<HTSPResponse> resp = std::make_shared<HTSPResponse>();
+  uint32_t seq = send([this, resp](htsmsg_t* reply) {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    resp->Set(reply);
+  });
+  if (!seq)
+    return nullptr;
+
   /* Wait for response */
-  msg = resp.Get(lock, iResponseTimeout);
-  m_messages.erase(seq);
-  if (!msg)
+  if (!resp->Wait(lock, iResponseTimeout))
   {
+    /* Cancel, a late response will be dropped */
+    m_messages.erase(seq);
     Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: No response received", method);
-    if (!m_suspended)
-      Disconnect();
 
+    /* Only restart the connection if the server doesn't respond at all */
+    if (!m_suspended && !IsAlive(lock, bytesRead))
+    {
+      Logger::Log(LogLevel::LEVEL_ERROR, "connection is not responding, reconnecting");
+      Disconnect();
+    }
     return nullptr;
   }
 
-  /* Check result for errors and announce. */
-  uint32_t noaccess = 0;
-  if (!htsmsg_get_u32(msg, "noaccess", &noaccess) && noaccess)
+  /* Errors already announced by CheckResponse */
+  return resp->Release();
+}
+
+/*
+ * Check whether the server still responds, without queueing a probe behind the request that timed
+ * out: the server handles the requests of a connection in order
+ */
+bool HTSPConnection::IsAlive(std::unique_lock<std::recursive_mutex>& lock, uint64_t bytesRead)
+{
+  /* Not registered yet, nothing else to ask */
+  if (!m_ready)
+    return false;
+
+  /* Anything received since the request was sent proves the connection alive */
+  if (m_rxBuffer.GetBytesRead() != bytesRead)
+    return true;
+
+  /* Otherwise the server may just be busy with the request, ask it on a connection of its own */
+  const uint32_t connections = m_connections;
+  lock.unlock();
+  const bool alive = ProbeServer();
+  lock.lock();
+
+  /* Reconnected meanwhile */
+  if (m_connections != connections)
+    return true;
+
+  return alive;
+}
+
+/*
+ * Say hello on a separate connection and wait for the answer
+ */
+bool HTSPConnection::ProbeServer() const
+{
+  TCPSocket socket(m_settings->GetHostname(), m_settings->GetPortHTSP());
+  if (!socket.Open(m_settings->GetConnectTimeout()))
   {
-    // access denied
-    Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: Access denied", method);
-    htsmsg_destroy(msg);
-    return nullptr;
+    Logger::Log(LogLevel::LEVEL_ERROR, "liveness probe failed to connect");
+    return false;
   }
-  else
+
+  std::vector<uint8_t> buffer;
+  HTSPMessageBuilder builder(buffer);
+  builder.AddStr("clientname", "Kodi Media Center");
+  builder.AddS64("htspversion", HTSP_CLIENT_VERSION);
+  builder.AddS64("seq", 1);
+  builder.AddStr("method", "hello");
+  builder.Finish();
+
+  bool alive = socket.Write(buffer.data(), buffer.size()) == static_cast<int64_t>(buffer.size());
+  if (alive)
   {
-    const char* strError = htsmsg_get_str(msg, "error");
-    if (strError)
+    /* Any complete answer will do */
+    ReceiveBuffer rxBuffer(4096);
+    alive = rxBuffer.Fill(socket, 4, m_settings->GetResponseTimeout());
+    if (alive)
     {
-      Logger::Log(LogLevel::LEVEL_ERROR, "Command %s failed: %s", method, strError);
-      htsmsg_destroy(msg);
-      return nullptr;
+      const uint8_t* lb = rxBuffer.Data();
+      const size_t len = (lb[0] << 24) + (lb[1] << 16) + (lb[2] << 8) + lb[3];
+      alive = rxBuffer.Fill(socket, 4 + len, m_settings->GetResponseTimeout());
     }
   }
 
-  return msg;
+  socket.Close();
+
+  if (!alive)
+    Logger::Log(LogLevel::LEVEL_ERROR, "liveness probe received no answer");
+
+  return alive;
+}
+
+/*
+ * Send a message and wait for response
+ */
+htsmsg_t* HTSPConnection::SendAndWait0(std::unique_lock<std::recursive_mutex>& lock,
+                                       const char* method,
+                                       htsmsg_t* msg,
+                                       int iResponseTimeout)
+{
+  return WaitForResponse(lock, method, iResponseTimeout, [&](HTSPResponseHandler handler) {
+    return SendAsync0(method, msg, std::move(handler));
+  });
+}
+
+htsmsg_t* HTSPConnection::SendAndWait0(std::unique_lock<std::recursive_mutex>& lock,
+                                       const char* method,
+                                       std::initializer_list<HTSPField> fields,
+                                       int iResponseTimeout)
+{
+  return WaitForResponse(lock, method, iResponseTimeout, [&](HTSPResponseHandler handler) {
+    return SendAsync0(method, fields, std::move(handler));
+  });
 }
 
 /*
@@ -472,15 +773,23 @@ htsmsg_t* HTSPConnection::SendAndWait(std::unique_lock<std::recursive_mutex>& lo
                                       htsmsg_t* msg,
                                       int iResponseTimeout)
 {
-  if (iResponseTimeout == -1)
-    iResponseTimeout = m_settings->GetResponseTimeout();
-
   if (!WaitForConnection(lock))
     return nullptr;
 
   return SendAndWait0(lock, method, msg, iResponseTimeout);
 }
 
+htsmsg_t* HTSPConnection::SendAndWait(std::unique_lock<std::recursive_mutex>& lock,
+                                      const char* method,
+                                      std::initializer_list<HTSPField> fields,
+                                      int iResponseTimeout)
+{
+  if (!WaitForConnection(lock))
+    return nullptr;
+
+  return SendAndWait0(lock, method, fields, iResponseTimeout);
+}
+
 bool HTSPConnection::SendHello(std::unique_lock<std::recursive_mutex>& lock)
 {
   /* Build message */
@@ -501,6 +810,7 @@ bool HTSPConnection::SendHello(std::unique_lock<std::recursive_mutex>& lock)
   m_serverVersion = htsmsg_get_str(msg, "serverversion");
   m_htspVersion = htsmsg_get_u32_or_default(msg, "htspversion", 0);
   m_webRoot = webroot ? webroot : "";
+  UpdateWebBaseURL();
   Logger::Log(LogLevel::LEVEL_DEBUG, "connected to %s / %s (HTSPv%d)", m_serverName.c_str(),
               m_serverVersion.c_str(), m_htspVersion);
 
@@ -669,6 +979,7 @@ void HTSPConnection::Process()
 
       m_connListener.Disconnected();
       m_socket = new TCPSocket(host, port);
+      m_rxBuffer.Reset();
       m_ready = false;
       m_seq = 0;
       if (m_challenge)
@@ -730,6 +1041,9 @@ void HTSPConnection::Process()
     log = false;
     retryAttempt = 0;
 
+    if (m_connections++ > 0)
+      Logger::Log(LogLevel::LEVEL_INFO, "reconnected (%u reconnects so far)", GetReconnectCount());
+
     /* Start connect thread */
     m_regThread->CreateThread();
 
@@ -9,6 +9,8 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <functional>
+#include <initializer_list>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -20,6 +22,9 @@ extern "C"
 #include "libhts/htsmsg.h"
 }
 
+#include "HTSPMessageBuilder.h"
+#include "utilities/ReceiveBuffer.h"
+
 #include "kodi/addon-instance/pvr/General.h"
 #include "kodi/tools/Thread.h"
 
@@ -27,7 +32,6 @@ namespace tvheadend
 {
 
 class HTSPRegister;
-class HTSPResponse;
 class IHTSPConnectionListener;
 class InstanceSettings;
 
@@ -36,7 +40,19 @@ namespace utilities
 class TCPSocket;
 }
 
-typedef std::map<uint32_t, HTSPResponse*> HTSPResponseList;
+/*
+ * Completion handler for asynchronous requests. Receives the response (ownership is passed to the
+ * handler) or nullptr if the request failed, was rejected by the server or the connection was lost.
+ */
+typedef std::function<void(htsmsg_t* msg)> HTSPResponseHandler;
+
+struct HTSPPendingRequest
+{
+  std::string method;
+  HTSPResponseHandler handler;
+};
+
+typedef std::map<uint32_t, HTSPPendingRequest> HTSPResponseList;
 
 /*
  * HTSP Connection
@@ -53,18 +69,82 @@ public:
   void Disconnect();
 
   bool SendMessage0(const char* method, htsmsg_t* m);
+
+  /**
+   * Send a request without waiting for the response. Any number of requests may be in flight.
+   * The handler is invoked exactly once, either on the connection thread when the response
+   * arrives or with nullptr on failure. It must not block waiting for other responses.
+   * Nothing is sent while the connection is not registered, the handler gets nullptr right away.
+   * @param method the HTSP method
+   * @param m the request message, ownership is taken
+   * @param handler the completion handler
+   * @return the sequence number of the request, 0 if it could not be sent
+   */
+  uint32_t SendAsync(const char* method, htsmsg_t* m, HTSPResponseHandler handler);
+
+  /**
+   * Same as above, but the request is encoded straight into the connection's send buffer
+   * @param method the HTSP method
+   * @param fields the request fields
+   * @param handler the completion handler
+   * @return the sequence number of the request, 0 if it could not be sent
+   */
+  uint32_t SendAsync(const char* method,
+                     std::initializer_list<HTSPField> fields,
+                     HTSPResponseHandler handler);
+
+  /**
+   * Cancel a pending request. Its handler is invoked with nullptr, a late response is dropped.
+   * @param seq the sequence number returned by SendAsync
+   */
+  void Cancel(uint32_t seq);
+
+  /*
+   * The SendAndWait variants wait iResponseTimeout ms for the response; -1 means the configured
+   * response timeout, scaled for methods known to be slow. A request that times out is cancelled.
+   * The connection is only restarted if the server does not respond to a probe either.
+   */
   htsmsg_t* SendAndWait0(std::unique_lock<std::recursive_mutex>& lock,
                          const char* method,
                          htsmsg_t* m,
                          int iResponseTimeout = -1);
+  htsmsg_t* SendAndWait0(std::unique_lock<std::recursive_mutex>& lock,
+                         const char* method,
+                         std::initializer_list<HTSPField> fields,
+                         int iResponseTimeout = -1);
   htsmsg_t* SendAndWait(std::unique_lock<std::recursive_mutex>& lock,
                         const char* method,
                         htsmsg_t* m,
                         int iResponseTimeout = -1);
+  htsmsg_t* SendAndWait(std::unique_lock<std::recursive_mutex>& lock,
+                        const char* method,
+                        std::initializer_list<HTSPField> fields,
+                        int iResponseTimeout = -1);
 
   int GetProtocol() const;
 
-  std::string GetWebURL(const char* fmt, ...) const;
+  /**
+   * @return true if the connection is registered, i.e. requests can be sent
+   */
+  bool IsReady() const;
+
+  /**
+   * @return the number of times the connection has been re-established
+   */
+  uint32_t GetReconnectCount() const;
+
+  /**
+   * @param path the path on the web server, a leading '/' is added if missing
+   * @return the URL of the path
+   */
+  std::string GetWebURL(const char* path) const;
+
+  /**
+   * @param url a URL, e.g. one returned by GetWebURL
+   * @return the path of the URL on the web server with a leading '/', or the URL itself if it
+   *         points elsewhere
+   */
+  std::string GetWebPath(const std::string& url) const;
 
   std::string GetServerName() const;
   std::string GetServerVersion() const;
@@ -78,6 +158,12 @@ public:
   void OnWake();
 
 private:
+  /* SendAsync, also while registering */
+  uint32_t SendAsync0(const char* method, htsmsg_t* m, HTSPResponseHandler handler);
+  uint32_t SendAsync0(const char* method,
+                      std::initializer_list<HTSPField> fields,
+                      HTSPResponseHandler handler);
+
   // CThread iplementation
   void Process() override;
 
@@ -85,7 +171,18 @@ private:
 
   void Register();
   bool ReadMessage();
+  bool WriteMessage(const char* method, const void* buf, size_t len);
+
+  uint32_t AddRequest(const char* method, HTSPResponseHandler handler);
+  void FailRequest(uint32_t seq);
+  bool IsAlive(std::unique_lock<std::recursive_mutex>& lock, uint64_t bytesRead);
+  bool ProbeServer() const;
+  htsmsg_t* WaitForResponse(std::unique_lock<std::recursive_mutex>& lock,
+                            const char* method,
+                            int iResponseTimeout,
+                            const std::function<uint32_t(HTSPResponseHandler)>& send);
   bool SendHello(std::unique_lock<std::recursive_mutex>& lock);
+  void UpdateWebBaseURL();
   bool SendAuth(std::unique_lock<std::recursive_mutex>& lock,
                 const std::string& u,
                 const std::string& p);
@@ -113,6 +210,8 @@ private:
   std::shared_ptr<InstanceSettings> m_settings;
   IHTSPConnectionListener& m_connListener;
   tvheadend::utilities::TCPSocket* m_socket = nullptr;
+  tvheadend::utilities::ReceiveBuffer m_rxBuffer;
+  std::vector<uint8_t> m_txBuffer;
   mutable std::recursive_mutex m_mutex;
   HTSPRegister* m_regThread;
   std::condition_variable_any m_regCond;
@@ -122,6 +221,7 @@ private:
   std::string m_serverVersion;
   int m_htspVersion;
   std::string m_webRoot;
+  std::string m_webBaseURL; // scheme, credentials, host, port and webroot of the web server
   void* m_challenge;
   int m_challengeLen;
 
@@ -132,6 +232,8 @@ private:
   PVR_CONNECTION_STATE m_state;
 
   std::atomic<bool> m_stopProcessing = false;
+
+  std::atomic<uint32_t> m_connections{0};
 };
 
 } // namespace tvheadend
@@ -9,12 +9,15 @@
 #include "HTSPDemuxer.h"
 
 #include "HTSPConnection.h"
+#include "HTSPSchema.h"
 #include "InstanceSettings.h"
 #include "utilities/Logger.h"
 #include "utilities/RDSExtractor.h"
 
 #include "kodi/addon-instance/PVR.h"
+#include "kodi/tools/StringUtils.h"
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <cstring>
@@ -34,18 +37,25 @@ static const int TVH_STREAM_INDEX_OFFSET = 1000;
 using namespace tvheadend;
 using namespace tvheadend::utilities;
 
+#define DEMUX_BUFFER_MAX_PACKETS (32768)
+#define DEMUX_BUFFER_BUDGET (64 * 1024 * 1024) // bytes
+
 HTSPDemuxer::HTSPDemuxer(const std::shared_ptr<InstanceSettings>& settings,
                          IHTSPDemuxPacketHandler& demuxPktHdl,
-                         HTSPConnection& conn)
+                         HTSPConnection& conn,
+                         ByteBudget& instanceBudget,
+                         RoutingTable<HTSPDemuxer>& routes)
   : m_settings(settings),
     m_conn(conn),
-    m_pktBuffer(static_cast<size_t>(-1)),
+    m_pktBuffer(DEMUX_BUFFER_MAX_PACKETS),
     m_seektime(nullptr),
-    m_subscription(conn),
+    m_subscription(conn, [this, &routes](uint32_t id) { routes.Set(this, id); }),
     m_lastUse(0),
     m_lastPkt(0),
     m_startTime(0),
     m_rdsIdx(0),
+    m_bufferBudget(DEMUX_BUFFER_BUDGET),
+    m_instanceBudget(instanceBudget),
     m_demuxPktHdl(demuxPktHdl)
 {
 }
@@ -62,24 +72,48 @@ void HTSPDemuxer::RebuildState()
     Logger::Log(LogLevel::LEVEL_DEBUG, "demux re-starting stream");
 
     std::unique_lock<std::recursive_mutex> lock(m_conn.Mutex());
+    Restart0(lock);
+  }
+}
 
-    m_subscription.SendUnsubscribe(lock);
-    m_subscription.SendSubscribe(lock, 0, 0, true);
-    m_subscription.SendSpeed(lock, 0, true);
+void HTSPDemuxer::Restart0(std::unique_lock<std::recursive_mutex>& lock)
+{
+  m_subscription.SendUnsubscribe();
+  m_subscription.SendSubscribe(lock, 0, 0, true);
+  m_subscription.SendSpeed(lock, 0, true);
 
-    ResetStatus(false);
-  }
+  ResetStatus(false);
+}
+
+void HTSPDemuxer::RestartAsync()
+{
+  std::lock_guard<std::recursive_mutex> lock(m_conn.Mutex());
+  if (!m_subscription.IsActive())
+    return;
+
+  m_subscription.SendUnsubscribe();
+  m_subscription.SendSubscribeAsync(0, 0, true, [this] {
+    /* Escalate, unless the connection is going down anyway */
+    if (!m_conn.IsReady())
+      return;
+
+    Logger::Log(LogLevel::LEVEL_WARNING, "demux restarting subscription failed; reconnecting");
+    m_conn.Disconnect();
+  });
+  m_subscription.SendSpeedAsync(m_subscription.GetSpeed(), true);
+
+  ResetStatus(false);
 }
 
 /* **************************************************************************
  * Demuxer API
  * *************************************************************************/
 
-void HTSPDemuxer::Close0(std::unique_lock<std::recursive_mutex>& lock)
+void HTSPDemuxer::Close0()
 {
   /* Send unsubscribe */
   if (m_subscription.IsActive())
-    m_subscription.SendUnsubscribe(lock);
+    m_subscription.SendUnsubscribe();
 
   /* Clear */
   Flush();
@@ -94,6 +128,9 @@ void HTSPDemuxer::Abort0()
   m_rdsIdx = 0;
   m_rdsExtractor.reset();
   m_seektime = nullptr;
+  m_overBudget = false;
+  m_throttled = false;
+  m_waitForKeyFrame = false;
 }
 
 
@@ -103,13 +140,14 @@ bool HTSPDemuxer::Open(uint32_t channelId, enum eSubscriptionWeight weight)
   Logger::Log(LogLevel::LEVEL_DEBUG, "demux open");
 
   /* Close current stream */
-  Close0(lock);
+  Close0();
 
   /* Open new subscription */
   time_t lastUse = m_lastUse.load();
   time_t lastPkt = m_lastPkt.load();
   m_lastUse.store(std::time(nullptr));
   m_lastPkt = 0;
+  m_restarted = false;
   m_subscription.SendSubscribe(lock, channelId, weight);
 
   /* Reset status */
@@ -118,7 +156,7 @@ bool HTSPDemuxer::Open(uint32_t channelId, enum eSubscriptionWeight weight)
   /* Send unsubscribe if subscribing failed */
   if (!m_subscription.IsActive())
   {
-    m_subscription.SendUnsubscribe(lock);
+    m_subscription.SendUnsubscribe();
     m_lastUse.store(lastUse);
     m_lastPkt.store(lastPkt);
     return false;
@@ -127,10 +165,28 @@ bool HTSPDemuxer::Open(uint32_t channelId, enum eSubscriptionWeight weight)
   return true;
 }
 
+void HTSPDemuxer::OpenAsync(uint32_t channelId, enum eSubscriptionWeight weight)
+{
+  std::unique_lock<std::recursive_mutex> lock(m_conn.Mutex());
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux open async");
+
+  /* Close current stream */
+  Close0();
+
+  /* Reset status before anything of the new subscription arrives */
+  ResetStatus();
+
+  /* Open new subscription */
+  m_lastUse.store(std::time(nullptr));
+  m_lastPkt = 0;
+  m_restarted = false;
+  m_subscription.SendSubscribeAsync(channelId, weight);
+}
+
 void HTSPDemuxer::Close()
 {
   std::unique_lock<std::recursive_mutex> lock(m_conn.Mutex());
-  Close0(lock);
+  Close0();
   ResetStatus();
   Logger::Log(LogLevel::LEVEL_DEBUG, "demux close");
 }
@@ -139,12 +195,13 @@ DEMUX_PACKET* HTSPDemuxer::Read()
 {
   m_lastUse.store(std::time(nullptr));
 
-  DEMUX_PACKET* pkt = nullptr;
-  if (m_pktBuffer.Pop(pkt, 100))
+  DEMUX_PACKET* pkt = PopPacket(100);
+  if (pkt)
   {
     Logger::Log(LogLevel::LEVEL_TRACE, "demux read idx :%d pts %lf len %lld", pkt->iStreamId,
                 pkt->pts, static_cast<long long>(pkt->iSize));
     m_lastPkt.store(m_lastUse.load());
+    m_restarted = false;
     return pkt;
   }
   Logger::Log(LogLevel::LEVEL_TRACE, "demux read nothing");
@@ -152,11 +209,26 @@ DEMUX_PACKET* HTSPDemuxer::Read()
   if (m_lastPkt > 0 && m_lastUse - m_lastPkt > m_settings->GetStreamStalledThreshold() &&
       !IsPaused())
   {
-    Logger::Log(LogLevel::LEVEL_WARNING,
-                "demux read no data for at least %d secs; restarting connection",
-                m_settings->GetStreamStalledThreshold());
-    m_lastPkt = 0;
-    m_conn.Disconnect();
+    if (m_restarted)
+    {
+      /* Restarting the subscription didn't help, restart the connection as a whole */
+      Logger::Log(LogLevel::LEVEL_WARNING,
+                  "demux read no data for at least %d secs after restart; reconnecting",
+                  m_settings->GetStreamStalledThreshold());
+      m_lastPkt = 0;
+      m_restarted = false;
+      m_conn.Disconnect();
+    }
+    else
+    {
+      /* Only this subscription is restarted, without waiting for the backend */
+      Logger::Log(LogLevel::LEVEL_WARNING,
+                  "demux read no data for at least %d secs; restarting subscription",
+                  m_settings->GetStreamStalledThreshold());
+      m_lastPkt.store(m_lastUse.load());
+      m_restarted = true;
+      RestartAsync();
+    }
   }
   return m_demuxPktHdl.AllocateDemuxPacket(0);
 }
@@ -166,7 +238,7 @@ void HTSPDemuxer::Flush()
   Logger::Log(LogLevel::LEVEL_TRACE, "demux flush");
 
   DEMUX_PACKET* pkt = nullptr;
-  while (m_pktBuffer.Pop(pkt))
+  while ((pkt = PopPacket()))
     m_demuxPktHdl.FreeDemuxPacket(pkt);
 }
 
@@ -174,12 +246,123 @@ void HTSPDemuxer::Trim()
 {
   Logger::Log(LogLevel::LEVEL_TRACE, "demux trim");
 
-  /* reduce used buffer space to what is needed for DVDPlayer to resume
-   * playback without buffering. This depends on the bitrate, so we don't set
-   * this too small. */
+  /* reduce used buffer space to what is needed to resume playback without
+   * buffering: everything from the most recent video key frame on. Without
+   * video, keep a fixed number of packets. */
+  uint64_t trimTo = m_keyFramePos;
+  if (!m_hasVideo)
+  {
+    const uint64_t pushed = m_pushedPackets;
+    trimTo = pushed > 512 ? pushed - 512 : 0;
+  }
+
   DEMUX_PACKET* pkt = nullptr;
-  while (m_pktBuffer.Size() > 512 && m_pktBuffer.Pop(pkt))
+  while (m_poppedPackets < trimTo && (pkt = PopPacket()))
+    m_demuxPktHdl.FreeDemuxPacket(pkt);
+}
+
+bool HTSPDemuxer::PushPacket(DEMUX_PACKET* pkt)
+{
+  if (!m_pktBuffer.Push(pkt))
+  {
+    Logger::Log(LogLevel::LEVEL_ERROR, "demux buffer full, dropping packet");
     m_demuxPktHdl.FreeDemuxPacket(pkt);
+    return false;
+  }
+
+  m_bufferBudget.Acquire(pkt->iSize);
+  m_instanceBudget.Acquire(pkt->iSize);
+  m_pushedPackets++;
+  return true;
+}
+
+DEMUX_PACKET* HTSPDemuxer::PopPacket(int32_t timeoutMs /* = 0 */)
+{
+  DEMUX_PACKET* pkt = nullptr;
+  if (m_pktBuffer.Pop(pkt, timeoutMs))
+  {
+    m_poppedPackets++;
+    m_bufferBudget.Release(pkt->iSize);
+    m_instanceBudget.Release(pkt->iSize);
+  }
+
+  /* Resume a throttled subscription once the buffer is drained, also if it is empty already */
+  if (m_throttled && IsBufferDrained() && m_throttled.exchange(false))
+    SendThrottleSpeed(false);
+
+  return pkt;
+}
+
+void HTSPDemuxer::SetStandby(bool standby)
+{
+  m_standby = standby;
+}
+
+bool HTSPDemuxer::IsOverBudget() const
+{
+  /* Only standby demuxers yield to the budget shared by all demuxers */
+  return m_bufferBudget.IsExceeded() || (m_standby && m_instanceBudget.IsExceeded());
+}
+
+bool HTSPDemuxer::IsBufferDrained() const
+{
+  return m_bufferBudget.IsBelowLowWatermark() &&
+         (!m_standby || m_instanceBudget.IsBelowLowWatermark());
+}
+
+bool HTSPDemuxer::CheckBufferBudget()
+{
+  if (!m_overBudget)
+  {
+    if (!IsOverBudget())
+      return true;
+
+    Logger::Log(LogLevel::LEVEL_DEBUG,
+                "demux buffer over budget (%zu of %zu bytes, instance %zu of %zu bytes)",
+                m_bufferBudget.GetUsed(), m_bufferBudget.GetLimit(), m_instanceBudget.GetUsed(),
+                m_instanceBudget.GetLimit());
+    m_overBudget = true;
+    m_droppedPackets = 0;
+
+    if (!m_throttled.exchange(true))
+      SendThrottleSpeed(true);
+  }
+
+  if (IsBufferDrained())
+  {
+    Logger::Log(LogLevel::LEVEL_DEBUG, "demux buffer drained, %u packets dropped",
+                m_droppedPackets);
+    m_overBudget = false;
+
+    /* The decoder can only resync at a key frame */
+    if (m_droppedPackets > 0 && m_hasVideo)
+      m_waitForKeyFrame = true;
+
+    return true;
+  }
+
+  m_droppedPackets++;
+  return false;
+}
+
+void HTSPDemuxer::SendThrottleSpeed(bool throttle)
+{
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux %s subscription %u", throttle ? "throttle" : "resume",
+              m_subscription.GetId());
+
+  /* Asynchronous, as this is called from the connection thread and from Kodi's demux thread.
+   * The throttle doesn't change the speed of the subscription, the resume restores the speed
+   * Kodi asked for meanwhile. */
+  if (throttle)
+    m_subscription.SendSpeedAsync(0, true);
+  else
+    m_subscription.SendSpeedAsync(m_requestedSpeed);
+}
+
+unsigned int HTSPDemuxer::GetBufferLevel() const
+{
+  return static_cast<unsigned int>(
+      std::min<size_t>(m_bufferBudget.GetUsed() * 100 / m_bufferBudget.GetLimit(), 100));
 }
 
 void HTSPDemuxer::Abort()
@@ -268,14 +451,18 @@ void HTSPDemuxer::Speed(int speed)
   {
     speed = SPEED_NORMAL;
     m_lastPkt = 0;
+    m_restarted = false;
   }
 
-  if ((speed != m_requestedSpeed || speed == 0) && m_actualSpeed == m_subscription.GetSpeed())
+  /* While throttled, the speed is sent when the subscription is resumed */
+  const int32_t previous = m_requestedSpeed.exchange(speed);
+  if (m_throttled)
+    return;
+
+  if ((speed != previous || speed == 0) && m_actualSpeed == m_subscription.GetSpeed())
   {
     m_subscription.SendSpeed(lock, speed);
   }
-
-  m_requestedSpeed = speed;
 }
 
 void HTSPDemuxer::FillBuffer(bool mode)
@@ -287,12 +474,14 @@ void HTSPDemuxer::FillBuffer(bool mode)
 
   int speed = (!mode || IsRealTimeStream()) ? SPEED_NORMAL : 4 * SPEED_NORMAL;
 
-  if (speed != m_requestedSpeed && m_actualSpeed == m_subscription.GetSpeed())
+  const int32_t previous = m_requestedSpeed.exchange(speed);
+  if (m_throttled)
+    return;
+
+  if (speed != previous && m_actualSpeed == m_subscription.GetSpeed())
   {
     m_subscription.SendSpeed(lock, speed);
   }
-
-  m_requestedSpeed = speed;
 }
 
 void HTSPDemuxer::Weight(enum eSubscriptionWeight weight)
@@ -302,7 +491,7 @@ void HTSPDemuxer::Weight(enum eSubscriptionWeight weight)
   if (!m_subscription.IsActive() || m_subscription.GetWeight() == static_cast<uint32_t>(weight))
     return;
 
-  m_subscription.SendWeight(lock, static_cast<uint32_t>(weight));
+  m_subscription.SendWeight(static_cast<uint32_t>(weight));
 }
 
 PVR_ERROR HTSPDemuxer::CurrentStreams(std::vector<kodi::addon::PVRStreamProperties>& streams)
@@ -323,7 +512,12 @@ PVR_ERROR HTSPDemuxer::CurrentSignal(kodi::addon::PVRSignalStatus& sig)
   sig.SetProviderName(m_sourceInfo.si_provider);
   sig.SetMuxName(m_sourceInfo.si_mux);
 
-  sig.SetAdapterStatus(m_signalInfo.fe_status);
+  /* Tells why playback may stutter */
+  if (m_throttled)
+    sig.SetAdapterStatus(kodi::tools::StringUtils::Format(
+        "%s (buffer %u%%, throttled)", m_signalInfo.fe_status.c_str(), GetBufferLevel()));
+  else
+    sig.SetAdapterStatus(m_signalInfo.fe_status);
   sig.SetSNR(m_signalInfo.fe_snr);
   sig.SetSignal(m_signalInfo.fe_signal);
   sig.SetBER(m_signalInfo.fe_ber);
@@ -498,7 +692,7 @@ void HTSPDemuxer::ProcessRDS(uint32_t idx, const void* bin, size_t binlen)
 
       DEMUX_PACKET* pktSpecial = m_demuxPktHdl.AllocateDemuxPacket(0);
       pktSpecial->iStreamId = DEMUX_SPECIALID_STREAMCHANGE;
-      m_pktBuffer.Push(pktSpecial);
+      PushPacket(pktSpecial);
     }
 
     DEMUX_PACKET* pkt = m_demuxPktHdl.AllocateDemuxPacket(rdslen);
@@ -512,33 +706,58 @@ void HTSPDemuxer::ProcessRDS(uint32_t idx, const void* bin, size_t binlen)
     pkt->iSize = rdslen;
     pkt->iStreamId = rdsIdx;
 
-    m_pktBuffer.Push(pkt);
+    PushPacket(pkt);
   }
   m_rdsExtractor->Reset();
 }
 
+namespace
+{
+
+/* muxpkt */
+constexpr HTSPSchema MUXPKT_SCHEMA({"stream", "payload", "duration", "dts", "pts", "frametype"});
+
+} // unnamed namespace
+
 void HTSPDemuxer::ParseMuxPacket(htsmsg_t* m)
 {
-  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+  const HTSPFields fields(MUXPKT_SCHEMA, m);
 
-  /* Ignore packets while switching channels */
-  if (!m_subscription.IsActive())
+  /* Validate fields */
+  HTSPMuxPacket pkt;
+  const void* bin = nullptr;
+  if (fields.GetU32("stream", &pkt.stream) || fields.GetBin("payload", &bin, &pkt.payloadLen))
   {
-    Logger::Log(LogLevel::LEVEL_DEBUG, "Ignored mux packet due to channel switch");
+    Logger::Log(LogLevel::LEVEL_ERROR, "malformed muxpkt: 'stream'/'payload' missing");
     return;
   }
+  pkt.payload = static_cast<const uint8_t*>(bin);
 
-  /* Validate fields */
-  uint32_t idx = 0;
-  const void* bin = nullptr;
-  size_t binlen = 0;
-  if (htsmsg_get_u32(m, "stream", &idx) || htsmsg_get_bin(m, "payload", &bin, &binlen))
+  pkt.hasDuration = !fields.GetU32("duration", &pkt.duration);
+  pkt.hasDts = !fields.GetS64("dts", &pkt.dts);
+  pkt.hasPts = !fields.GetS64("pts", &pkt.pts);
+  fields.GetU32("frametype", &pkt.frametype);
+
+  ProcessMuxPacket(pkt);
+}
+
+void HTSPDemuxer::ProcessMuxPacket(const HTSPMuxPacket& muxpkt)
+{
+  /* Backpressure; must not hold m_mutex as it may send a request */
+  if (!CheckBufferBudget())
+    return;
+
+  std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+  /* Ignore packets while switching channels */
+  if (!m_subscription.IsActive())
   {
-    Logger::Log(LogLevel::LEVEL_ERROR, "malformed muxpkt: 'stream'/'payload' missing");
+    Logger::Log(LogLevel::LEVEL_DEBUG, "Ignored mux packet due to channel switch");
     return;
   }
 
-  idx += TVH_STREAM_INDEX_OFFSET;
+  const uint32_t idx = muxpkt.stream + TVH_STREAM_INDEX_OFFSET;
+  const size_t binlen = muxpkt.payloadLen;
 
   /* Drop packets for unknown streams */
   if (m_streamStat.find(idx) == m_streamStat.end())
@@ -547,6 +766,16 @@ void HTSPDemuxer::ParseMuxPacket(htsmsg_t* m)
     return;
   }
 
+  /* Resume at a video key frame after packets were dropped */
+  if (m_waitForKeyFrame)
+  {
+    if (muxpkt.frametype != 'I' || !IsVideoStream(idx))
+      return;
+
+    Logger::Log(LogLevel::LEVEL_DEBUG, "demux buffering resumed at key frame");
+    m_waitForKeyFrame = false;
+  }
+
   /* Record */
   m_streamStat[idx]++;
 
@@ -555,31 +784,27 @@ void HTSPDemuxer::ParseMuxPacket(htsmsg_t* m)
   if (!pkt)
     return;
 
-  std::memcpy(pkt->pData, bin, binlen);
+  std::memcpy(pkt->pData, muxpkt.payload, binlen);
   pkt->iSize = binlen;
   pkt->iStreamId = idx;
 
   /* Duration */
-  uint32_t u32 = 0;
-  if (!htsmsg_get_u32(m, "duration", &u32))
-    pkt->duration = TVH_TO_DVD_TIME(u32);
+  if (muxpkt.hasDuration)
+    pkt->duration = TVH_TO_DVD_TIME(muxpkt.duration);
 
   /* Timestamps */
-  int64_t s64 = 0;
-  if (!htsmsg_get_s64(m, "dts", &s64))
-    pkt->dts = TVH_TO_DVD_TIME(s64);
+  if (muxpkt.hasDts)
+    pkt->dts = TVH_TO_DVD_TIME(muxpkt.dts);
   else
     pkt->dts = STREAM_NOPTS_VALUE;
 
-  if (!htsmsg_get_s64(m, "pts", &s64))
-    pkt->pts = TVH_TO_DVD_TIME(s64);
+  if (muxpkt.hasPts)
+    pkt->pts = TVH_TO_DVD_TIME(muxpkt.pts);
   else
     pkt->pts = STREAM_NOPTS_VALUE;
 
-  /* Type (for debug only) */
-  char type = 0;
-  if (!htsmsg_get_u32(m, "frametype", &u32))
-    type = static_cast<char>(u32);
+  /* Type */
+  char type = static_cast<char>(muxpkt.frametype);
   if (!type)
     type = '_';
 
@@ -597,15 +822,30 @@ void HTSPDemuxer::ParseMuxPacket(htsmsg_t* m)
       // first paket for this subscription
       m_startTime = std::time(nullptr);
     }
-    m_pktBuffer.Push(pkt);
+    if (!PushPacket(pkt))
+      return;
+
+    /* Remember where a standby buffer can be trimmed to */
+    if (type == 'I' && IsVideoStream(idx))
+      m_keyFramePos = m_pushedPackets - 1;
 
     // Process RDS data, if present.
-    ProcessRDS(idx, bin, binlen);
+    ProcessRDS(idx, muxpkt.payload, binlen);
   }
   else
     m_demuxPktHdl.FreeDemuxPacket(pkt);
 }
 
+bool HTSPDemuxer::IsVideoStream(uint32_t idx) const
+{
+  for (const auto& stream : m_streams)
+  {
+    if (stream.GetPID() == idx)
+      return stream.GetCodecType() == PVR_CODEC_TYPE_VIDEO;
+  }
+  return false;
+}
+
 bool HTSPDemuxer::AddRDSStream(uint32_t audioIdx, uint32_t rdsIdx)
 {
   for (const auto& stream : m_streams)
@@ -803,12 +1043,16 @@ void HTSPDemuxer::ParseSubscriptionStart(htsmsg_t* m)
     AddTVHStream(idx, type, f);
   }
 
+  m_hasVideo = std::any_of(m_streams.cbegin(), m_streams.cend(), [](const auto& stream) {
+    return stream.GetCodecType() == PVR_CODEC_TYPE_VIDEO;
+  });
+
   /* Update streams */
   Logger::Log(LogLevel::LEVEL_DEBUG, "demux stream change");
 
   DEMUX_PACKET* pkt = m_demuxPktHdl.AllocateDemuxPacket(0);
   pkt->iStreamId = DEMUX_SPECIALID_STREAMCHANGE;
-  m_pktBuffer.Push(pkt);
+  PushPacket(pkt);
 
   /* Source data */
   ParseSourceInfo(htsmsg_get_map(m, "sourceinfo"));
@@ -899,6 +1143,10 @@ void HTSPDemuxer::ParseSubscriptionSpeed(htsmsg_t* m)
   if (!htsmsg_get_s32(m, "speed", &s32))
     Logger::Log(LogLevel::LEVEL_TRACE, "recv speed %d", s32);
 
+  /* The throttle is no speed change of Kodi's, see SendThrottleSpeed() */
+  if (m_throttled && s32 == 0)
+    return;
+
   std::lock_guard<std::recursive_mutex> lock(m_conn.Mutex());
   m_actualSpeed = s32 * 10;
 }
@@ -932,6 +1180,12 @@ void HTSPDemuxer::ParseQueueStatus(htsmsg_t* m)
     Logger::Log(LogLevel::LEVEL_TRACE, "  Pdrop %d", u32);
   if (!htsmsg_get_u32(m, "Bdrops", &u32))
     Logger::Log(LogLevel::LEVEL_TRACE, "  Bdrop %d", u32);
+
+  Logger::Log(LogLevel::LEVEL_TRACE, "local buffer:");
+  Logger::Log(LogLevel::LEVEL_TRACE, "  pkts  %zu", m_pktBuffer.Size());
+  Logger::Log(LogLevel::LEVEL_TRACE, "  bytes %zu", m_bufferBudget.GetUsed());
+  Logger::Log(LogLevel::LEVEL_TRACE, "  level %u%%%s", GetBufferLevel(),
+              m_throttled ? " (throttled)" : "");
 }
 
 void HTSPDemuxer::ParseSignalStatus(htsmsg_t* m)
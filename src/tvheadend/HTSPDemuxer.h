@@ -20,13 +20,16 @@ extern "C"
 #include "libhts/htsmsg.h"
 }
 
+#include "HTSPMuxPacket.h"
 #include "IHTSPDemuxPacketHandler.h"
 #include "Subscription.h"
 #include "status/DescrambleInfo.h"
 #include "status/Quality.h"
 #include "status/SourceInfo.h"
 #include "status/TimeshiftStatus.h"
-#include "utilities/SyncedBuffer.h"
+#include "utilities/ByteBudget.h"
+#include "utilities/RingBuffer.h"
+#include "utilities/RoutingTable.h"
 
 #include "kodi/addon-instance/pvr/Channels.h"
 #include "kodi/addon-instance/pvr/Stream.h"
@@ -45,23 +48,48 @@ class RDSExtractor;
 
 /*
  * HTSP Demuxer - live streams
+ *
+ * Buffered packets are accounted against a byte budget per demuxer and one shared by all demuxers
+ * of the instance. When the demuxer's budget is exceeded, or the shared one for a standby demuxer,
+ * the server is asked to pause the subscription (subscriptionSpeed 0, effective if the server has
+ * timeshift enabled) and all packets that still arrive are dropped. Once the exceeded budgets are
+ * drained below half, the subscription is resumed with the speed last requested by Kodi. After
+ * packets were dropped, buffering restarts at the next video key frame.
  */
 class HTSPDemuxer
 {
 public:
   HTSPDemuxer(const std::shared_ptr<InstanceSettings>& settings,
               IHTSPDemuxPacketHandler& demuxPktHdl,
-              HTSPConnection& conn);
+              HTSPConnection& conn,
+              utilities::ByteBudget& instanceBudget,
+              utilities::RoutingTable<HTSPDemuxer>& routes);
   ~HTSPDemuxer();
 
   bool ProcessMessage(const std::string& method, htsmsg_t* m);
+  void ProcessMuxPacket(const HTSPMuxPacket& muxpkt);
   void RebuildState();
 
   bool Open(uint32_t channelId,
             tvheadend::eSubscriptionWeight weight = tvheadend::SUBSCRIPTION_WEIGHT_NORMAL);
+  /**
+   * Like Open, but doesn't wait for the backend to confirm the subscription
+   * @param channelId the channel to subscribe to
+   * @param weight the desired subscription weight
+   */
+  void OpenAsync(uint32_t channelId, tvheadend::eSubscriptionWeight weight);
   void Close();
   DEMUX_PACKET* Read();
+  /**
+   * Drops the buffered packets preceding the most recent video key frame, so that playback of a
+   * standby demuxer can start right away once it is promoted to the active one
+   */
   void Trim();
+  /**
+   * Marks a demuxer that buffers a predictive tuning subscription. Only standby demuxers are
+   * throttled when the budget shared by all demuxers is exceeded, never the one being played.
+   */
+  void SetStandby(bool standby);
   void Flush();
   void Abort();
   bool Seek(double time, bool backwards, double& startpts);
@@ -82,6 +110,21 @@ public:
   time_t GetLastUse() const;
   bool IsPaused() const;
 
+  /**
+   * @return the number of bytes currently buffered by this demuxer
+   */
+  size_t GetBufferedBytes() const { return m_bufferBudget.GetUsed(); }
+
+  /**
+   * @return the fill level of the packet buffer in percent of its budget
+   */
+  unsigned int GetBufferLevel() const;
+
+  /**
+   * @return true while the subscription is paused because the packet buffer is full
+   */
+  bool IsThrottled() const { return m_throttled; }
+
   /**
    * Tells each demuxer to use the specified profile for new subscriptions
    * @param profile the profile to use
@@ -89,9 +132,21 @@ public:
   void SetStreamingProfile(const std::string& profile);
 
 private:
-  void Close0(std::unique_lock<std::recursive_mutex>& lock);
+  void Close0();
   void Abort0();
 
+  /**
+   * Restarts the current subscription, keeping channel, weight and speed
+   * @param lock the locked connection mutex
+   */
+  void Restart0(std::unique_lock<std::recursive_mutex>& lock);
+
+  /**
+   * Restarts the current subscription without waiting for the backend. The connection is
+   * restarted if the backend rejects the subscription.
+   */
+  void RestartAsync();
+
   /**
    * Resets the signal, quality, timeshift info and optionally the starttime
    * @param resetStartTime if true, all subscription-related data will be reset
@@ -110,6 +165,14 @@ private:
   void ParseTimeshiftStatus(htsmsg_t* m);
   void ParseDescrambleInfo(htsmsg_t* m);
 
+  bool PushPacket(DEMUX_PACKET* pkt);
+  DEMUX_PACKET* PopPacket(int32_t timeoutMs = 0);
+  bool IsOverBudget() const;
+  bool IsBufferDrained() const;
+  bool CheckBufferBudget();
+  void SendThrottleSpeed(bool throttle);
+
+  bool IsVideoStream(uint32_t idx) const;
   bool AddTVHStream(uint32_t idx, const char* type, htsmsg_field_t* f);
   bool AddRDSStream(uint32_t audioIdx, uint32_t rdsIdx);
   void ProcessRDS(uint32_t idx, const void* bin, size_t binlen);
@@ -117,7 +180,7 @@ private:
   mutable std::recursive_mutex m_mutex;
   std::shared_ptr<InstanceSettings> m_settings;
   HTSPConnection& m_conn;
-  tvheadend::utilities::SyncedBuffer<DEMUX_PACKET*> m_pktBuffer;
+  tvheadend::utilities::RingBuffer<DEMUX_PACKET*> m_pktBuffer;
   std::vector<kodi::addon::PVRStreamProperties> m_streams;
   std::map<int, int> m_streamStat;
   std::atomic<SubscriptionSeekTime*> m_seektime;
@@ -128,11 +191,23 @@ private:
   tvheadend::Subscription m_subscription;
   std::atomic<time_t> m_lastUse;
   std::atomic<time_t> m_lastPkt;
+  std::atomic<bool> m_restarted{false}; // restarted after a stall, no packet since
   std::atomic<time_t> m_startTime;
   uint32_t m_rdsIdx;
   std::unique_ptr<utilities::RDSExtractor> m_rdsExtractor;
-  int32_t m_requestedSpeed = 1000;
+  std::atomic<int32_t> m_requestedSpeed{1000}; // the speed last requested by Kodi
   int32_t m_actualSpeed = 1000;
+  utilities::ByteBudget m_bufferBudget;
+  utilities::ByteBudget& m_instanceBudget;
+  std::atomic<bool> m_standby{false};
+  std::atomic<bool> m_overBudget{false};
+  std::atomic<bool> m_throttled{false};
+  std::atomic<bool> m_waitForKeyFrame{false}; // drop packets after an overflow until a key frame
+  uint32_t m_droppedPackets = 0;
+  std::atomic<uint64_t> m_pushedPackets{0};
+  std::atomic<uint64_t> m_poppedPackets{0};
+  std::atomic<uint64_t> m_keyFramePos{0}; // m_pushedPackets at the most recent video key frame
+  std::atomic<bool> m_hasVideo{false};
 
   IHTSPDemuxPacketHandler& m_demuxPktHdl;
 };
@@ -0,0 +1,88 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "HTSPMessageBuilder.h"
+
+extern "C"
+{
+#include "libhts/htsmsg.h"
+}
+
+#include <cstring>
+
+using namespace tvheadend;
+
+HTSPMessageBuilder::HTSPMessageBuilder(std::vector<uint8_t>& buffer) : m_buffer(buffer)
+{
+  /* Room for the length prefix */
+  m_buffer.assign(4, 0);
+}
+
+HTSPMessageBuilder& HTSPMessageBuilder::Add(const HTSPField& field)
+{
+  switch (field.m_type)
+  {
+    case HTSPField::S64:
+      return AddS64(field.m_name, field.m_s64);
+    case HTSPField::STR:
+      return AddStr(field.m_name, field.m_str);
+    case HTSPField::BIN:
+      return AddBin(field.m_name, field.m_bin, field.m_binLen);
+  }
+  return *this;
+}
+
+HTSPMessageBuilder& HTSPMessageBuilder::AddS64(const char* name, int64_t value)
+{
+  /* Little endian, without trailing zero bytes */
+  uint8_t data[8];
+  size_t len = 0;
+  for (uint64_t u64 = static_cast<uint64_t>(value); u64 != 0; u64 >>= 8)
+    data[len++] = static_cast<uint8_t>(u64 & 0xFF);
+
+  AddHeader(HMF_S64, name, std::strlen(name), len);
+  m_buffer.insert(m_buffer.end(), data, data + len);
+  return *this;
+}
+
+HTSPMessageBuilder& HTSPMessageBuilder::AddStr(const char* name, const char* value)
+{
+  const size_t len = std::strlen(value);
+  AddHeader(HMF_STR, name, std::strlen(name), len);
+  m_buffer.insert(m_buffer.end(), value, value + len);
+  return *this;
+}
+
+HTSPMessageBuilder& HTSPMessageBuilder::AddBin(const char* name, const void* value, size_t len)
+{
+  const uint8_t* data = static_cast<const uint8_t*>(value);
+  AddHeader(HMF_BIN, name, std::strlen(name), len);
+  m_buffer.insert(m_buffer.end(), data, data + len);
+  return *this;
+}
+
+const std::vector<uint8_t>& HTSPMessageBuilder::Finish()
+{
+  const size_t len = m_buffer.size() - 4;
+  m_buffer[0] = static_cast<uint8_t>(len >> 24);
+  m_buffer[1] = static_cast<uint8_t>(len >> 16);
+  m_buffer[2] = static_cast<uint8_t>(len >> 8);
+  m_buffer[3] = static_cast<uint8_t>(len);
+  return m_buffer;
+}
+
+void HTSPMessageBuilder::AddHeader(uint8_t type, const char* name, size_t namelen, size_t datalen)
+{
+  const uint8_t header[6] = {type,
+                             static_cast<uint8_t>(namelen),
+                             static_cast<uint8_t>(datalen >> 24),
+                             static_cast<uint8_t>(datalen >> 16),
+                             static_cast<uint8_t>(datalen >> 8),
+                             static_cast<uint8_t>(datalen)};
+  m_buffer.insert(m_buffer.end(), header, header + sizeof(header));
+  m_buffer.insert(m_buffer.end(), name, name + namelen);
+}
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tvheadend
+{
+
+/*
+ * A single field of a flat HTSP message
+ */
+class HTSPField
+{
+public:
+  HTSPField(const char* name, int64_t value) : m_name(name), m_type(S64), m_s64(value) {}
+  HTSPField(const char* name, int32_t value) : m_name(name), m_type(S64), m_s64(value) {}
+  HTSPField(const char* name, uint32_t value) : m_name(name), m_type(S64), m_s64(value) {}
+  HTSPField(const char* name, const char* value) : m_name(name), m_type(STR), m_str(value) {}
+  HTSPField(const char* name, const void* value, size_t len)
+    : m_name(name), m_type(BIN), m_bin(value), m_binLen(len)
+  {
+  }
+
+private:
+  friend class HTSPMessageBuilder;
+
+  enum Type
+  {
+    S64,
+    STR,
+    BIN
+  };
+
+  const char* m_name;
+  Type m_type;
+  int64_t m_s64 = 0;
+  const char* m_str = nullptr;
+  const void* m_bin = nullptr;
+  size_t m_binLen = 0;
+};
+
+/*
+ * Encodes a flat HTSP message straight into its binary wire format, without building an htsmsg
+ * tree. The output is identical to htsmsg_binary_serialize for the same fields.
+ */
+class HTSPMessageBuilder
+{
+public:
+  /**
+   * @param buffer the buffer to encode into, its previous content is discarded
+   */
+  HTSPMessageBuilder(std::vector<uint8_t>& buffer);
+
+  HTSPMessageBuilder& Add(const HTSPField& field);
+  HTSPMessageBuilder& AddS64(const char* name, int64_t value);
+  HTSPMessageBuilder& AddStr(const char* name, const char* value);
+  HTSPMessageBuilder& AddBin(const char* name, const void* value, size_t len);
+
+  /**
+   * Write the length prefix
+   * @return the complete message
+   */
+  const std::vector<uint8_t>& Finish();
+
+private:
+  void AddHeader(uint8_t type, const char* name, size_t namelen, size_t datalen);
+
+  std::vector<uint8_t>& m_buffer;
+};
+
+} // namespace tvheadend
@@ -0,0 +1,157 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "HTSPMuxPacket.h"
+
+extern "C"
+{
+#include "libhts/htsmsg.h"
+}
+
+#include <cstring>
+
+using namespace tvheadend;
+
+namespace
+{
+
+enum MuxPacketField
+{
+  FIELD_METHOD = 0x01,
+  FIELD_SUBSCRIPTION_ID = 0x02,
+  FIELD_STREAM = 0x04,
+  FIELD_FRAMETYPE = 0x08,
+  FIELD_DURATION = 0x10,
+  FIELD_DTS = 0x20,
+  FIELD_PTS = 0x40,
+  FIELD_PAYLOAD = 0x80,
+};
+
+const uint32_t REQUIRED_FIELDS = FIELD_METHOD | FIELD_SUBSCRIPTION_ID | FIELD_STREAM | FIELD_PAYLOAD;
+
+bool NameIs(const uint8_t* name, size_t namelen, const char* str)
+{
+  return std::strlen(str) == namelen && std::memcmp(name, str, namelen) == 0;
+}
+
+/* Same encoding as htsmsg_binary_des0 */
+int64_t DecodeS64(const uint8_t* data, size_t len)
+{
+  uint64_t u64 = 0;
+  for (size_t i = len; i > 0; --i)
+    u64 = (u64 << 8) | data[i - 1];
+  return static_cast<int64_t>(u64);
+}
+
+bool DecodeU32(const uint8_t* data, size_t len, uint32_t& u32)
+{
+  const int64_t s64 = DecodeS64(data, len);
+  if (s64 < 0 || s64 > 0xffffffffLL)
+    return false;
+
+  u32 = static_cast<uint32_t>(s64);
+  return true;
+}
+
+} // unnamed namespace
+
+bool tvheadend::DecodeMuxPacket(const uint8_t* data, size_t len, HTSPMuxPacket& pkt)
+{
+  uint32_t found = 0;
+
+  while (len > 5)
+  {
+    const unsigned type = data[0];
+    const size_t namelen = data[1];
+    const size_t datalen = (static_cast<size_t>(data[2]) << 24) | (data[3] << 16) |
+                           (data[4] << 8) | data[5];
+
+    data += 6;
+    len -= 6;
+
+    if (len < namelen + datalen)
+      return false;
+
+    const uint8_t* name = data;
+    const uint8_t* value = data + namelen;
+    data += namelen + datalen;
+    len -= namelen + datalen;
+
+    /* Only flat messages with integer and binary fields are handled here */
+    uint32_t field = 0;
+    if (NameIs(name, namelen, "method"))
+    {
+      if (type != HMF_STR || !NameIs(value, datalen, "muxpkt"))
+        return false;
+      field = FIELD_METHOD;
+    }
+    else if (NameIs(name, namelen, "payload"))
+    {
+      if (type != HMF_BIN)
+        return false;
+      field = FIELD_PAYLOAD;
+      if (!(found & field))
+      {
+        pkt.payload = value;
+        pkt.payloadLen = datalen;
+      }
+    }
+    else if (type != HMF_S64)
+    {
+      if (type != HMF_STR && type != HMF_BIN && type != HMF_MAP && type != HMF_LIST)
+        return false; // let the generic decoder reject it
+
+      continue; // unknown field
+    }
+    else if (NameIs(name, namelen, "subscriptionId"))
+    {
+      field = FIELD_SUBSCRIPTION_ID;
+      if (!(found & field) && !DecodeU32(value, datalen, pkt.subscriptionId))
+        return false;
+    }
+    else if (NameIs(name, namelen, "stream"))
+    {
+      field = FIELD_STREAM;
+      if (!(found & field) && !DecodeU32(value, datalen, pkt.stream))
+        return false;
+    }
+    else if (NameIs(name, namelen, "frametype"))
+    {
+      field = FIELD_FRAMETYPE;
+      if (!(found & field) && !DecodeU32(value, datalen, pkt.frametype))
+        return false;
+    }
+    else if (NameIs(name, namelen, "duration"))
+    {
+      field = FIELD_DURATION;
+      if (!(found & field))
+        pkt.hasDuration = DecodeU32(value, datalen, pkt.duration);
+    }
+    else if (NameIs(name, namelen, "dts"))
+    {
+      field = FIELD_DTS;
+      if (!(found & field))
+      {
+        pkt.dts = DecodeS64(value, datalen);
+        pkt.hasDts = true;
+      }
+    }
+    else if (NameIs(name, namelen, "pts"))
+    {
+      field = FIELD_PTS;
+      if (!(found & field))
+      {
+        pkt.pts = DecodeS64(value, datalen);
+        pkt.hasPts = true;
+      }
+    }
+
+    found |= field;
+  }
+
+  return (found & REQUIRED_FIELDS) == REQUIRED_FIELDS;
+}
@@ -0,0 +1,43 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tvheadend
+{
+
+/*
+ * The fields of a muxpkt message. The payload is not owned.
+ */
+struct HTSPMuxPacket
+{
+  uint32_t subscriptionId = 0;
+  uint32_t stream = 0;
+  uint32_t frametype = 0;
+  bool hasDuration = false;
+  uint32_t duration = 0;
+  bool hasDts = false;
+  int64_t dts = 0;
+  bool hasPts = false;
+  int64_t pts = 0;
+  const uint8_t* payload = nullptr;
+  size_t payloadLen = 0;
+};
+
+/**
+ * Decode a muxpkt straight from its binary representation, without building an htsmsg tree
+ * @param data the message data (without the length prefix)
+ * @param len the message length
+ * @param pkt the decoded packet, the payload points into data
+ * @return false if the message is not a well-formed muxpkt; it must then take the generic path
+ */
+bool DecodeMuxPacket(const uint8_t* data, size_t len, HTSPMuxPacket& pkt);
+
+} // namespace tvheadend
@@ -0,0 +1,226 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+extern "C"
+{
+#include "libhts/htsmsg.h"
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace tvheadend
+{
+
+/**
+ * FNV-1a hash of a field name, usable at compile time
+ * @param name the field name
+ * @param seed the seed to mix in
+ * @return the hash value
+ */
+constexpr uint32_t HashFieldName(const char* name, uint32_t seed)
+{
+  uint32_t hash = 2166136261u ^ seed;
+  while (*name)
+  {
+    hash ^= static_cast<uint8_t>(*name++);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/*
+ * The top level field names of an HTSP message type. A perfect hash over the names is computed at
+ * compile time, so looking up a name costs one hash and one string compare.
+ */
+template<size_t N>
+class HTSPSchema
+{
+public:
+  constexpr HTSPSchema(const char* const (&names)[N])
+  {
+    for (size_t i = 0; i < N; ++i)
+      m_names[i] = names[i];
+
+    /* Find a seed that maps all names to distinct slots */
+    while (!TryFill())
+      ++m_seed;
+  }
+
+  /**
+   * @param name the field name
+   * @return the index of the name, or N if it is not part of the schema
+   */
+  constexpr size_t Find(const char* name) const
+  {
+    const size_t idx = m_table[HashFieldName(name, m_seed) & (TABLE_SIZE - 1)];
+    return (idx < N && Equals(m_names[idx], name)) ? idx : N;
+  }
+
+private:
+  static constexpr size_t TableSize()
+  {
+    size_t size = 1;
+    while (size < 4 * N)
+      size <<= 1;
+    return size;
+  }
+
+  static constexpr size_t TABLE_SIZE = TableSize();
+
+  static constexpr bool Equals(const char* a, const char* b)
+  {
+    while (*a && *a == *b)
+    {
+      ++a;
+      ++b;
+    }
+    return *a == *b;
+  }
+
+  constexpr bool TryFill()
+  {
+    for (size_t i = 0; i < TABLE_SIZE; ++i)
+      m_table[i] = N;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+      const size_t slot = HashFieldName(m_names[i], m_seed) & (TABLE_SIZE - 1);
+      if (m_table[slot] != N)
+        return false;
+      m_table[slot] = i;
+    }
+    return true;
+  }
+
+  const char* m_names[N] = {};
+  size_t m_table[TABLE_SIZE] = {};
+  uint32_t m_seed = 0;
+};
+
+/*
+ * The fields of a received message, indexed by a schema in a single pass over the message. The
+ * getters behave like their htsmsg_get_* counterparts. Names that are not part of the schema are
+ * looked up in the message.
+ */
+template<size_t N>
+class HTSPFields
+{
+public:
+  HTSPFields(const HTSPSchema<N>& schema, htsmsg_t* msg) : m_schema(schema), m_msg(msg)
+  {
+    htsmsg_field_t* f = nullptr;
+    HTSMSG_FOREACH(f, msg)
+    {
+      if (!f->hmf_name)
+        continue;
+
+      /* First occurrence wins, like htsmsg_field_find */
+      const size_t idx = m_schema.Find(f->hmf_name);
+      if (idx < N && !m_fields[idx])
+        m_fields[idx] = f;
+    }
+  }
+
+  int GetS64(const char* name, int64_t* s64p) const
+  {
+    htsmsg_field_t* f = Find(name);
+    return f ? htsmsg_field_get_s64(f, s64p) : HTSMSG_ERR_FIELD_NOT_FOUND;
+  }
+
+  int GetS32(const char* name, int32_t* s32p) const
+  {
+    int64_t s64 = 0;
+    int r = GetS64(name, &s64);
+    if (r != 0)
+      return r;
+
+    if (s64 < -0x80000000LL || s64 > 0x7fffffffLL)
+      return HTSMSG_ERR_CONVERSION_IMPOSSIBLE;
+
+    *s32p = static_cast<int32_t>(s64);
+    return 0;
+  }
+
+  int GetU32(const char* name, uint32_t* u32p) const
+  {
+    int64_t s64 = 0;
+    int r = GetS64(name, &s64);
+    if (r != 0)
+      return r;
+
+    if (s64 < 0 || s64 > 0xffffffffLL)
+      return HTSMSG_ERR_CONVERSION_IMPOSSIBLE;
+
+    *u32p = static_cast<uint32_t>(s64);
+    return 0;
+  }
+
+  uint32_t GetU32OrDefault(const char* name, uint32_t def) const
+  {
+    uint32_t u32 = 0;
+    return GetU32(name, &u32) ? def : u32;
+  }
+
+  const char* GetStr(const char* name) const
+  {
+    htsmsg_field_t* f = Find(name);
+    return f ? htsmsg_field_get_string(f) : nullptr;
+  }
+
+  int GetBin(const char* name, const void** binp, size_t* lenp) const
+  {
+    htsmsg_field_t* f = Find(name);
+    if (!f)
+      return HTSMSG_ERR_FIELD_NOT_FOUND;
+
+    if (f->hmf_type != HMF_BIN)
+      return HTSMSG_ERR_CONVERSION_IMPOSSIBLE;
+
+    *binp = f->hmf_bin;
+    *lenp = f->hmf_binsize;
+    return 0;
+  }
+
+  htsmsg_t* GetList(const char* name) const
+  {
+    htsmsg_field_t* f = Find(name);
+    return (f && f->hmf_type == HMF_LIST) ? &f->hmf_msg : nullptr;
+  }
+
+  htsmsg_t* GetMap(const char* name) const
+  {
+    htsmsg_field_t* f = Find(name);
+    return (f && f->hmf_type == HMF_MAP) ? &f->hmf_msg : nullptr;
+  }
+
+private:
+  htsmsg_field_t* Find(const char* name) const
+  {
+    const size_t idx = m_schema.Find(name);
+    if (idx < N)
+      return m_fields[idx];
+
+    /* Not part of the schema, fall back to a linear search */
+    htsmsg_field_t* f = nullptr;
+    HTSMSG_FOREACH(f, m_msg)
+    {
+      if (f->hmf_name && !std::strcmp(f->hmf_name, name))
+        return f;
+    }
+    return nullptr;
+  }
+
+  const HTSPSchema<N>& m_schema;
+  htsmsg_t* m_msg;
+  htsmsg_field_t* m_fields[N] = {};
+};
+
+} // namespace tvheadend
@@ -13,8 +13,10 @@
 
 #include <algorithm>
 #include <deque>
+#include <functional>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace tvheadend
@@ -145,4 +147,30 @@ struct SHTSPEvent
 
 typedef std::vector<SHTSPEvent> SHTSPEventList;
 
+/* Identifies a pending EPG update. Only the latest update per key is transferred to Kodi. */
+struct SHTSPEventKey
+{
+  uint32_t m_eventId;
+  uint32_t m_channelId;
+  EPG_EVENT_STATE m_state;
+
+  bool operator==(const SHTSPEventKey& right) const
+  {
+    return m_eventId == right.m_eventId && m_channelId == right.m_channelId &&
+           m_state == right.m_state;
+  }
+
+  struct Hash
+  {
+    size_t operator()(const SHTSPEventKey& key) const
+    {
+      const uint64_t ids = (static_cast<uint64_t>(key.m_channelId) << 32) | key.m_eventId;
+      return std::hash<uint64_t>()(ids) ^ static_cast<size_t>(key.m_state);
+    }
+  };
+};
+
+/* Pending EPG updates by key, as index into the SHTSPEventList */
+typedef std::unordered_map<SHTSPEventKey, size_t, SHTSPEventKey::Hash> SHTSPEventIndex;
+
 } // namespace tvheadend
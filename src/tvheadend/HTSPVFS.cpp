@@ -13,20 +13,114 @@ extern "C"
 }
 #include "HTSPConnection.h"
 #include "HTSPTypes.h"
+#include "HTTPRangeReader.h"
 #include "InstanceSettings.h"
 #include "utilities/Logger.h"
+#include "utilities/LruCache.h"
 
 #include "kodi/addon-instance/pvr/Recordings.h"
 #include "kodi/tools/StringUtils.h"
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
+#include <cstring>
 #include <ctime>
+#include <deque>
 #include <mutex>
-#include <thread>
+#include <vector>
 
 using namespace tvheadend;
 using namespace tvheadend::utilities;
 
+#define VFS_READAHEAD_CHUNK_SIZE (256 * 1024) // bytes, chunks are aligned to their size
+#define VFS_READAHEAD_MIN_WINDOW (2) // requests
+#define VFS_READAHEAD_MAX_WINDOW (16) // requests
+#define VFS_CACHE_SIZE (16 * 1024 * 1024) // bytes
+#define VFS_SIZE_MAX_AGE (2) // seconds, of the size of in-progress recordings
+#define VFS_BITRATE_WINDOW (60) // seconds
+#define VFS_BITRATE_MIN_WINDOW (5) // seconds
+#define VFS_TAIL_TIMEOUT (500) // ms, to wait for an in-progress recording to grow
+#define VFS_TAIL_MIN_BACKOFF (10) // ms
+#define VFS_TAIL_MAX_BACKOFF (160) // ms
+#define VFS_HTTP_CONNECTIONS (4)
+
+struct HTSPVFS::ReadAheadChunk
+{
+  ~ReadAheadChunk()
+  {
+    if (msg)
+      htsmsg_destroy(msg);
+  }
+
+  int64_t offset = 0;
+  uint32_t seq = 0;
+  bool http = false; // read over HTTP, seq is the HTTPRangeReader id
+  bool done = false;
+  bool failed = false;
+  htsmsg_t* msg = nullptr; // the fileRead response, owns the data
+  std::vector<uint8_t> buffer; // owns the data read over HTTP
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+
+  /**
+   * @return the number of bytes copied from the given file offset, which must be in the chunk
+   */
+  size_t Copy(int64_t from, unsigned char* buf, unsigned int len) const
+  {
+    const size_t pos = static_cast<size_t>(from - offset);
+    if (pos >= size)
+      return 0;
+
+    const size_t read = std::min(static_cast<size_t>(len), size - pos);
+    std::memcpy(buf, data + pos, read);
+    return read;
+  }
+};
+
+struct HTSPVFS::ReadAheadState
+{
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::deque<std::shared_ptr<ReadAheadChunk>> chunks; // in file order
+  int64_t nextOffset = 0;
+  size_t window = VFS_READAHEAD_MIN_WINDOW; // the number of chunks to request ahead
+
+  /* Complete chunks already read, by offset / VFS_READAHEAD_CHUNK_SIZE */
+  LruCache<int64_t, std::shared_ptr<ReadAheadChunk>> cache{VFS_CACHE_SIZE};
+};
+
+struct HTSPVFS::SizeState
+{
+  /**
+   * Adds a size seen for the in-progress recording, sizes only grow
+   */
+  void Update(int64_t newSize)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    if (newSize > size)
+    {
+      size = newSize;
+      condition.notify_all();
+    }
+    updated = now;
+
+    samples.emplace_back(now, size);
+    while (samples.size() > 2 &&
+           now - samples.front().first > std::chrono::seconds(VFS_BITRATE_WINDOW))
+      samples.pop_front();
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition; // notified when the size grows
+  uint32_t generation = 0; // incremented when the file is closed, to ignore late responses
+  int64_t size = -1;
+  bool final = false; // the recording has finished, the size will not change any more
+  bool pending = false; // a fileStat request is in flight
+  std::chrono::steady_clock::time_point updated;
+  std::deque<std::pair<std::chrono::steady_clock::time_point, int64_t>> samples; // oldest first
+};
+
 /*
  * VFS handler
  */
@@ -39,7 +133,9 @@ HTSPVFS::HTSPVFS(const std::shared_ptr<InstanceSettings>& settings, HTSPConnecti
     m_eofOffsetSecs(-1),
     m_pauseTime(0),
     m_paused(false),
-    m_isRealTimeStream(false)
+    m_isRealTimeStream(false),
+    m_readAhead(std::make_shared<ReadAheadState>()),
+    m_size(std::make_shared<SizeState>())
 {
 }
 
@@ -52,6 +148,8 @@ void HTSPVFS::RebuildState()
   /* Re-open */
   if (m_fileId != 0)
   {
+    DropReadAhead();
+
     Logger::Log(LogLevel::LEVEL_DEBUG, "vfs re-open file");
     if (!SendFileOpen(true) || !SendFileSeek(m_offset, SEEK_SET, true))
     {
@@ -88,6 +186,27 @@ bool HTSPVFS::Open(const kodi::addon::PVRRecording& rec)
 
 void HTSPVFS::Close()
 {
+  DropReadAhead();
+  m_http.reset();
+
+  {
+    std::lock_guard<std::mutex> lock(m_readAhead->mutex);
+    LruCache<int64_t, std::shared_ptr<ReadAheadChunk>>& cache = m_readAhead->cache;
+    if (cache.GetHits() > 0)
+      Logger::Log(LogLevel::LEVEL_DEBUG, "vfs cache hits=%zu misses=%zu", cache.GetHits(),
+                  cache.GetMisses());
+    cache.Clear();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_size->mutex);
+    ++m_size->generation;
+    m_size->size = -1;
+    m_size->final = false;
+    m_size->pending = false;
+    m_size->samples.clear();
+  }
+
   if (m_fileId != 0)
     SendFileClose();
 
@@ -106,23 +225,15 @@ int64_t HTSPVFS::Read(unsigned char* buf, unsigned int len, bool inprogress)
   if (!m_fileId)
     return -1;
 
-  /* Tvheadend may briefly return 0 bytes when playing an in-progress recording at end-of-file
-     we'll retry 50 times with 10ms pauses (~500ms) before giving up */
-  int tries = inprogress ? 50 : 1;
-  int64_t read = 0;
+  int64_t read = ReadAt(buf, len);
+
+  /* Tvheadend may briefly return 0 bytes when playing an in-progress recording at end-of-file */
+  if (read <= 0 && inprogress)
+    read = ReadTail(buf, len);
+
+  if (read > 0)
+    m_offset += read;
 
-  for (int i = 1; i <= tries; i++)
-  {
-    read = SendFileRead(buf, len);
-    if (read > 0)
-    {
-      m_offset += read;
-      return read;
-    }
-    else if (i < tries)
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-  }
-  Logger::Log(LogLevel::LEVEL_DEBUG, "vfs read failed after %d attempts", tries);
   return read;
 }
 
@@ -131,19 +242,32 @@ long long HTSPVFS::Seek(long long pos, int whence, bool inprogress)
   if (m_fileId == 0)
     return -1;
 
-  long long ret = SendFileSeek(pos, whence);
+  long long ret = -1;
+  const int64_t target = whence == SEEK_CUR ? m_offset + pos : pos;
+
+  /* Reads pass their offset, so a seek to data already read needs no round trip */
+  if ((whence == SEEK_SET || whence == SEEK_CUR) && IsCached(target))
+  {
+    Logger::Log(LogLevel::LEVEL_TRACE, "vfs seek offset=%lld (cached)",
+                static_cast<long long>(target));
+    m_offset = target;
+    ret = target;
+  }
+  else
+  {
+    DropReadAhead();
+
+    /* The server's file position is not m_offset, reads pass their offset and run ahead */
+    ret = whence == SEEK_CUR ? SendFileSeek(target, SEEK_SET) : SendFileSeek(pos, whence);
+  }
 
   /* for inprogress recordings see whether we need to toggle IsRealTimeStream */
   if (inprogress)
   {
-    int64_t fileLengthSecs = std::time(nullptr) - m_fileStart;
-    int64_t fileSize = Size();
-    int64_t bitrate = 0;
+    const int64_t fileSize = Size(true);
+    const int64_t bitrate = GetBitrate(fileSize);
     m_eofOffsetSecs = -1;
 
-    if (fileLengthSecs > 0)
-      bitrate = fileSize / fileLengthSecs;
-
     if (bitrate > 0)
       m_eofOffsetSecs = (fileSize - m_offset) > 0 ? (fileSize - m_offset) / bitrate : 0;
 
@@ -162,34 +286,75 @@ long long HTSPVFS::Seek(long long pos, int whence, bool inprogress)
   return ret;
 }
 
-long long HTSPVFS::Size()
+long long HTSPVFS::Size(bool inprogress)
 {
-  int64_t ret = -1;
-
-  /* Build */
-  htsmsg_t* m = htsmsg_create_map();
-  htsmsg_add_u32(m, "id", m_fileId);
+  int64_t size = -1;
+  bool refresh = false;
+  {
+    std::lock_guard<std::mutex> lock(m_size->mutex);
 
-  Logger::Log(LogLevel::LEVEL_TRACE, "vfs stat id=%d", m_fileId);
+    if (m_size->final || (inprogress && m_size->size > 0))
+    {
+      size = m_size->size;
+      refresh = !m_size->final && std::chrono::steady_clock::now() - m_size->updated >
+                                      std::chrono::seconds(VFS_SIZE_MAX_AGE);
+    }
+  }
 
-  /* Send */
+  if (size > 0)
   {
-    std::unique_lock<std::recursive_mutex> lock(m_conn.Mutex());
-    m = m_conn.SendAndWait(lock, "fileStat", m);
+    /* A slightly old size is fine while the recording grows, the new one arrives later */
+    if (refresh)
+      RequestFileStat();
+
+    return size;
   }
 
-  if (!m)
-    return -1;
+  /* Not known yet, or a recording that just finished without its final size */
+  size = SendFileStat();
+  if (size > 0)
+    UpdateFilesSize(size, inprogress);
 
-  /* Get size. Note: 'size' field is optional. */
-  if (htsmsg_get_s64(m, "size", &ret))
-    ret = -1;
+  return size;
+}
+
+void HTSPVFS::UpdateFilesSize(int64_t size, bool inprogress)
+{
+  if (size <= 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_size->mutex);
+
+  if (inprogress)
+    m_size->Update(size);
   else
-    Logger::Log(LogLevel::LEVEL_TRACE, "vfs stat size=%lld", static_cast<long long>(ret));
+  {
+    m_size->size = size;
+    m_size->final = true;
+    m_size->condition.notify_all();
+  }
+}
 
-  htsmsg_destroy(m);
+int64_t HTSPVFS::GetBitrate(int64_t fileSize)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_size->mutex);
 
-  return ret;
+    if (m_size->samples.size() >= 2)
+    {
+      const auto& first = m_size->samples.front();
+      const auto& last = m_size->samples.back();
+      const int64_t secs =
+          std::chrono::duration_cast<std::chrono::seconds>(last.first - first.first).count();
+
+      if (secs >= VFS_BITRATE_MIN_WINDOW && last.second > first.second)
+        return (last.second - first.second) / secs;
+    }
+  }
+
+  /* Not enough recent sizes yet, fall back to the average over the whole recording */
+  const int64_t fileLengthSecs = std::time(nullptr) - m_fileStart;
+  return fileLengthSecs > 0 && fileSize > 0 ? fileSize / fileLengthSecs : 0;
 }
 
 void HTSPVFS::PauseStream(bool paused)
@@ -334,19 +499,86 @@ long long HTSPVFS::SendFileSeek(int64_t pos, int whence, bool force)
   return ret;
 }
 
-int64_t HTSPVFS::SendFileRead(unsigned char* buf, unsigned int len)
+long long HTSPVFS::SendFileStat()
 {
+  int64_t ret = -1;
+
   /* Build */
   htsmsg_t* m = htsmsg_create_map();
   htsmsg_add_u32(m, "id", m_fileId);
-  htsmsg_add_s64(m, "size", len);
 
-  Logger::Log(LogLevel::LEVEL_TRACE, "vfs read id=%d size=%d", m_fileId, len);
+  Logger::Log(LogLevel::LEVEL_TRACE, "vfs stat id=%d", m_fileId);
 
   /* Send */
   {
     std::unique_lock<std::recursive_mutex> lock(m_conn.Mutex());
-    m = m_conn.SendAndWait(lock, "fileRead", m);
+    m = m_conn.SendAndWait(lock, "fileStat", m);
+  }
+
+  if (!m)
+    return -1;
+
+  /* Get size. Note: 'size' field is optional. */
+  if (htsmsg_get_s64(m, "size", &ret))
+    ret = -1;
+  else
+    Logger::Log(LogLevel::LEVEL_TRACE, "vfs stat size=%lld", static_cast<long long>(ret));
+
+  htsmsg_destroy(m);
+
+  return ret;
+}
+
+void HTSPVFS::RequestFileStat()
+{
+  const std::shared_ptr<SizeState> state = m_size;
+  uint32_t generation = 0;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    if (state->pending || state->final)
+      return;
+
+    state->pending = true;
+    generation = state->generation;
+  }
+
+  Logger::Log(LogLevel::LEVEL_TRACE, "vfs stat id=%d (async)", m_fileId);
+
+  /* Must not be sent with the size locked, a failed request completes right away */
+  m_conn.SendAsync("fileStat", {{"id", m_fileId}},
+                   [state, generation](htsmsg_t* msg)
+                   {
+                     int64_t size = -1;
+                     if (msg)
+                     {
+                       if (htsmsg_get_s64(msg, "size", &size))
+                         size = -1;
+
+                       htsmsg_destroy(msg);
+                     }
+
+                     std::lock_guard<std::mutex> lock(state->mutex);
+                     if (state->generation != generation)
+                       return;
+
+                     state->pending = false;
+                     if (size > 0 && !state->final)
+                       state->Update(size);
+                   });
+}
+
+int64_t HTSPVFS::SendFileRead(unsigned char* buf, unsigned int len)
+{
+  Logger::Log(LogLevel::LEVEL_TRACE, "vfs read id=%d offset=%lld size=%d", m_fileId,
+              static_cast<long long>(m_offset), len);
+
+  /* Send */
+  htsmsg_t* m = nullptr;
+  {
+    std::unique_lock<std::recursive_mutex> lock(m_conn.Mutex());
+    m = m_conn.SendAndWait(
+        lock, "fileRead",
+        {{"id", m_fileId}, {"size", static_cast<int64_t>(len)}, {"offset", m_offset}});
   }
 
   if (!m)
@@ -374,3 +606,334 @@ int64_t HTSPVFS::SendFileRead(unsigned char* buf, unsigned int len)
 
   return read;
 }
+
+/* **************************************************************************
+ * Read-ahead
+ * *************************************************************************/
+
+int64_t HTSPVFS::ReadAt(unsigned char* buf, unsigned int len)
+{
+  const int64_t read = ReadAhead(buf, len);
+
+  /* The blocking read waits for a reconnect, if that is why the read-ahead failed */
+  return read < 0 ? SendFileRead(buf, len) : read;
+}
+
+int64_t HTSPVFS::ReadTail(unsigned char* buf, unsigned int len)
+{
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(VFS_TAIL_TIMEOUT);
+  auto backoff = std::chrono::milliseconds(VFS_TAIL_MIN_BACKOFF);
+  int64_t tried = m_offset; // the size the last read failed at
+  int64_t read = 0;
+  int tries = 0;
+
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    /* Ask for the size, its growth (or a dvrEntryUpdate) tells when to read again */
+    RequestFileStat();
+
+    bool grown = false;
+    bool sized = false;
+    {
+      std::unique_lock<std::mutex> lock(m_size->mutex);
+      const auto until = std::min(deadline, std::chrono::steady_clock::now() + backoff);
+      grown = m_size->condition.wait_until(lock, until,
+                                           [this, tried] { return m_size->size > tried; });
+      sized = m_size->size > 0;
+
+      /* The recording finished meanwhile, there will be no more data */
+      if (m_size->final && m_size->size <= m_offset)
+        break;
+
+      if (grown)
+        tried = m_size->size;
+    }
+
+    backoff = std::min(backoff * 2, std::chrono::milliseconds(VFS_TAIL_MAX_BACKOFF));
+
+    /* Without sizes from the server, fall back to reading when the timer expires */
+    if (!grown && sized)
+      continue;
+
+    /* Restarts the read-ahead on the new data right away */
+    ++tries;
+    read = ReadAt(buf, len);
+    if (read > 0)
+      return read;
+  }
+
+  Logger::Log(LogLevel::LEVEL_DEBUG, "vfs tail read failed after %d attempts", tries);
+  return read;
+}
+
+int64_t HTSPVFS::ReadAhead(unsigned char* buf, unsigned int len)
+{
+  ReadAheadState& state = *m_readAhead;
+  const int64_t size = GetGrowingSize();
+
+  /* Data read before, e.g. when Kodi seeks back after probing */
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    const std::shared_ptr<ReadAheadChunk>* cached =
+        state.cache.Get(m_offset / VFS_READAHEAD_CHUNK_SIZE);
+    if (cached)
+      return (*cached)->Copy(m_offset, buf, len);
+  }
+
+  if (!SkipReadAheadTo(m_offset))
+    DropReadAhead();
+
+  FillReadAhead();
+
+  size_t read = 0;
+  bool endOfFile = false;
+  {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (state.chunks.empty())
+      return -1;
+
+    const std::shared_ptr<ReadAheadChunk> chunk = state.chunks.front();
+    if (!chunk->done)
+    {
+      /* The reader waits for the network, keep more requests in flight. Not when it waits for
+       * an in-progress recording to grow, more requests won't help with that. */
+      const bool tail =
+          size > 0 && chunk->offset + static_cast<int64_t>(VFS_READAHEAD_CHUNK_SIZE) > size;
+      if (!tail && state.window < VFS_READAHEAD_MAX_WINDOW)
+        ++state.window;
+
+      if (!state.condition.wait_for(lock,
+                                    std::chrono::milliseconds(m_settings->GetResponseTimeout()),
+                                    [&chunk] { return chunk->done; }))
+      {
+        Logger::Log(LogLevel::LEVEL_ERROR, "vfs fileRead timed out");
+        chunk->failed = true;
+      }
+    }
+    else if (state.chunks.back()->done && state.window > VFS_READAHEAD_MIN_WINDOW)
+    {
+      /* Everything requested has arrived before it was needed, fewer requests will do */
+      --state.window;
+    }
+
+    if (!chunk->failed)
+    {
+      read = chunk->Copy(m_offset, buf, len);
+
+      const int64_t chunkEnd = chunk->offset + static_cast<int64_t>(chunk->size);
+      if (m_offset + static_cast<int64_t>(read) >= chunkEnd)
+      {
+        /* A short read marks the current end of the file, the chunks behind it are useless */
+        endOfFile = chunk->size < VFS_READAHEAD_CHUNK_SIZE;
+        if (!endOfFile)
+          state.cache.Put(chunk->offset / VFS_READAHEAD_CHUNK_SIZE, chunk, chunk->size);
+
+        state.chunks.pop_front();
+      }
+    }
+  }
+
+  if (read == 0 || endOfFile)
+    DropReadAhead();
+
+  return read > 0 ? static_cast<int64_t>(read) : (endOfFile ? 0 : -1);
+}
+
+bool HTSPVFS::SkipReadAheadTo(int64_t offset)
+{
+  std::lock_guard<std::mutex> lock(m_readAhead->mutex);
+
+  /* After a seek within the read-ahead, see Seek() */
+  std::deque<std::shared_ptr<ReadAheadChunk>>& chunks = m_readAhead->chunks;
+  while (!chunks.empty() && chunks.front()->done && !chunks.front()->failed &&
+         chunks.front()->size == VFS_READAHEAD_CHUNK_SIZE &&
+         chunks.front()->offset + VFS_READAHEAD_CHUNK_SIZE <= offset)
+  {
+    m_readAhead->cache.Put(chunks.front()->offset / VFS_READAHEAD_CHUNK_SIZE, chunks.front(),
+                           VFS_READAHEAD_CHUNK_SIZE);
+    chunks.pop_front();
+  }
+
+  if (chunks.empty())
+    return m_readAhead->nextOffset == offset - offset % VFS_READAHEAD_CHUNK_SIZE;
+
+  const ReadAheadChunk& chunk = *chunks.front();
+  return chunk.offset <= offset && offset < chunk.offset + VFS_READAHEAD_CHUNK_SIZE;
+}
+
+bool HTSPVFS::IsCached(int64_t offset)
+{
+  if (offset < 0)
+    return false;
+
+  std::lock_guard<std::mutex> lock(m_readAhead->mutex);
+
+  if (m_readAhead->cache.Contains(offset / VFS_READAHEAD_CHUNK_SIZE))
+    return true;
+
+  return std::any_of(m_readAhead->chunks.cbegin(), m_readAhead->chunks.cend(),
+                     [offset](const std::shared_ptr<ReadAheadChunk>& chunk)
+                     {
+                       return chunk->done && !chunk->failed && chunk->offset <= offset &&
+                              offset < chunk->offset + static_cast<int64_t>(chunk->size);
+                     });
+}
+
+void HTSPVFS::FillReadAhead()
+{
+  const std::shared_ptr<ReadAheadState> state = m_readAhead;
+  const bool http = UseHTTP();
+  const int64_t size = GetGrowingSize();
+
+  while (true)
+  {
+    std::shared_ptr<ReadAheadChunk> chunk;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (state->chunks.size() >= state->window)
+        return;
+
+      /* Of an in-progress recording only what is there already, one chunk waits at the end */
+      if (size > 0 && !state->chunks.empty() && state->nextOffset >= size)
+        break;
+
+      chunk = std::make_shared<ReadAheadChunk>();
+      chunk->offset = state->nextOffset;
+      chunk->http = http;
+      state->nextOffset += VFS_READAHEAD_CHUNK_SIZE;
+      state->chunks.emplace_back(chunk);
+    }
+
+    Logger::Log(LogLevel::LEVEL_TRACE, "vfs read id=%d offset=%lld size=%d%s", m_fileId,
+                static_cast<long long>(chunk->offset), VFS_READAHEAD_CHUNK_SIZE,
+                http ? " (http)" : "");
+
+    /* Must not be sent with the read-ahead locked, a failed request completes right away */
+    uint32_t seq = 0;
+    if (http)
+    {
+      seq = m_http->Read(chunk->offset, VFS_READAHEAD_CHUNK_SIZE,
+                         [state, chunk](std::vector<uint8_t>* data)
+                         {
+                           std::lock_guard<std::mutex> lock(state->mutex);
+
+                           if (data)
+                           {
+                             chunk->buffer.swap(*data);
+                             chunk->data = chunk->buffer.data();
+                             chunk->size = chunk->buffer.size();
+                           }
+                           else
+                             chunk->failed = true;
+
+                           chunk->done = true;
+                           state->condition.notify_all();
+                         });
+    }
+    else
+    {
+      seq = m_conn.SendAsync(
+          "fileRead",
+          {{"id", m_fileId},
+           {"size", static_cast<int64_t>(VFS_READAHEAD_CHUNK_SIZE)},
+           {"offset", chunk->offset}},
+          [state, chunk](htsmsg_t* msg)
+          {
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            const void* data = nullptr;
+            size_t size = 0;
+            if (msg && !htsmsg_get_bin(msg, "data", &data, &size))
+            {
+              chunk->msg = msg;
+              chunk->data = static_cast<const uint8_t*>(data);
+              chunk->size = size;
+            }
+            else
+            {
+              if (msg)
+              {
+                Logger::Log(LogLevel::LEVEL_ERROR, "malformed fileRead response: 'data' missing");
+                htsmsg_destroy(msg);
+              }
+              else
+                Logger::Log(LogLevel::LEVEL_ERROR, "vfs fileRead failed");
+
+              chunk->failed = true;
+            }
+
+            chunk->done = true;
+            state->condition.notify_all();
+          });
+    }
+
+    if (seq == 0)
+      return;
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    chunk->seq = seq;
+  }
+
+  /* The read-ahead continues once a newer size arrived */
+  bool refresh = false;
+  {
+    std::lock_guard<std::mutex> lock(m_size->mutex);
+    refresh = std::chrono::steady_clock::now() - m_size->updated >
+              std::chrono::seconds(VFS_SIZE_MAX_AGE);
+  }
+  if (refresh)
+    RequestFileStat();
+}
+
+int64_t HTSPVFS::GetGrowingSize()
+{
+  std::lock_guard<std::mutex> lock(m_size->mutex);
+  return m_size->final ? -1 : m_size->size;
+}
+
+bool HTSPVFS::UseHTTP()
+{
+  if (!m_settings->GetDvrPlaybackHTTP() || (m_http && m_http->HasFailed()))
+    return false;
+
+  /* The HTTP connections would not see an in-progress recording grow */
+  {
+    std::lock_guard<std::mutex> lock(m_size->mutex);
+    if (!m_size->final)
+      return false;
+  }
+
+  /* Its threads are only started when needed, the file stays open over HTSP for the fallback */
+  if (!m_http)
+  {
+    const std::string path = "dvrfile/" + m_recordingId;
+    m_http = std::make_unique<HTTPRangeReader>(m_conn.GetWebURL(path.c_str()),
+                                               VFS_HTTP_CONNECTIONS);
+  }
+
+  return true;
+}
+
+void HTSPVFS::DropReadAhead()
+{
+  std::vector<uint32_t> pending;
+  std::vector<uint32_t> pendingHTTP;
+  {
+    std::lock_guard<std::mutex> lock(m_readAhead->mutex);
+    for (const auto& chunk : m_readAhead->chunks)
+    {
+      if (!chunk->done && chunk->seq != 0)
+        (chunk->http ? pendingHTTP : pending).emplace_back(chunk->seq);
+    }
+    m_readAhead->chunks.clear();
+    m_readAhead->nextOffset = m_offset - m_offset % VFS_READAHEAD_CHUNK_SIZE;
+  }
+
+  /* Outside the lock, as cancelling completes the requests */
+  for (uint32_t seq : pending)
+    m_conn.Cancel(seq);
+
+  for (uint32_t seq : pendingHTTP)
+    m_http->Cancel(seq);
+}
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -22,6 +23,7 @@ namespace tvheadend
 {
 
 class HTSPConnection;
+class HTTPRangeReader;
 class InstanceSettings;
 
 /*
@@ -42,15 +44,86 @@ public:
   void Close();
   int64_t Read(unsigned char* buf, unsigned int len, bool inprogress);
   long long Seek(long long pos, int whence, bool inprogress);
-  long long Size();
+
+  /**
+   * The size of finished recordings is known from the recording metadata. For in-progress
+   * recordings a recent size is returned, refreshed in the background once it got old.
+   * @return the file size or -1 if unknown
+   */
+  long long Size(bool inprogress);
+
+  /**
+   * Updates the size from the recording metadata (dvrEntryAdd/dvrEntryUpdate filesSize)
+   */
+  void UpdateFilesSize(int64_t size, bool inprogress);
+
   void PauseStream(bool paused);
   bool IsRealTimeStream();
 
 private:
+  struct ReadAheadChunk;
+  struct ReadAheadState;
+  struct SizeState;
+
   bool SendFileOpen(bool force = false);
   void SendFileClose();
   int64_t SendFileRead(unsigned char* buf, unsigned int len);
   long long SendFileSeek(int64_t pos, int whence, bool force = false);
+  long long SendFileStat();
+
+  /**
+   * Sends a fileStat request unless one is in flight or the size is final. The response updates
+   * the size
+   */
+  void RequestFileStat();
+
+  /**
+   * @return the recent growth of an in-progress recording in bytes per second, 0 if unknown
+   */
+  int64_t GetBitrate(int64_t fileSize);
+
+  /**
+   * @return the last known size of an in-progress recording, -1 if unknown or finished
+   */
+  int64_t GetGrowingSize();
+
+  /**
+   * Read at the current offset, from the read-ahead or with a blocking request
+   * @return the number of bytes read, 0 at the end of the file, -1 on failure
+   */
+  int64_t ReadAt(unsigned char* buf, unsigned int len);
+
+  /**
+   * Read at the end of an in-progress recording, waiting a short while for the file to grow.
+   * Reads are only repeated once the file size grew or after a growing backoff time.
+   * @return the number of bytes read, 0 at the end of the file, -1 on failure
+   */
+  int64_t ReadTail(unsigned char* buf, unsigned int len);
+
+  /**
+   * Read from the read-ahead, which is (re)started at the current offset if needed
+   * @return the number of bytes read, 0 at the end of the file, -1 on failure
+   */
+  int64_t ReadAhead(unsigned char* buf, unsigned int len);
+
+  /**
+   * Moves the read-ahead forward to the offset, keeping the chunks skipped in the cache
+   * @return true if the first chunk of the read-ahead contains the offset
+   */
+  bool SkipReadAheadTo(int64_t offset);
+
+  /**
+   * @return true if the data at the offset has been read already and can be served locally
+   */
+  bool IsCached(int64_t offset);
+  void FillReadAhead();
+
+  /**
+   * Creates the HTTP reader the first time it is used
+   * @return true if the read-ahead should read over HTTP, only done for finished recordings
+   */
+  bool UseHTTP();
+  void DropReadAhead();
 
   std::shared_ptr<InstanceSettings> m_settings;
   HTSPConnection& m_conn;
@@ -63,6 +136,15 @@ private:
   int64_t m_pauseTime;
   bool m_paused;
   bool m_isRealTimeStream;
+
+  /* fileRead requests in flight, shared with their completion handlers */
+  std::shared_ptr<ReadAheadState> m_readAhead;
+
+  /* reads recordings over HTTP if enabled, HTSP is used when it fails. Created on first use */
+  std::unique_ptr<HTTPRangeReader> m_http;
+
+  /* the known file size, shared with the completion handlers of fileStat */
+  std::shared_ptr<SizeState> m_size;
 };
 
 } // namespace tvheadend
@@ -0,0 +1,172 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "HTTPRangeReader.h"
+
+#include "utilities/Logger.h"
+
+#include "kodi/Filesystem.h"
+#include "kodi/tools/Thread.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace tvheadend;
+using namespace tvheadend::utilities;
+
+/*
+ * Reader thread, with a connection of its own
+ */
+class HTTPRangeReader::Worker : public kodi::tools::CThread
+{
+public:
+  Worker(HTTPRangeReader& reader) : m_reader(reader) { CreateThread(); }
+
+  ~Worker() override { StopThread(); }
+
+private:
+  // CThread implementation
+  void Process() override
+  {
+    Request request;
+    while (m_reader.Next(request))
+    {
+      std::vector<uint8_t> data;
+      if (ReadRange(request.offset, request.size, data))
+      {
+        request.handler(&data);
+      }
+      else
+      {
+        m_reader.m_failed = true;
+        request.handler(nullptr);
+      }
+    }
+  }
+
+  bool ReadRange(int64_t offset, size_t size, std::vector<uint8_t>& data)
+  {
+    /* Kodi's VFS sends a ranged request when seeking, if needed */
+    if (!m_open)
+    {
+      m_open = m_file.OpenFile(m_reader.m_url, ADDON_READ_NO_CACHE);
+      if (!m_open)
+      {
+        Logger::Log(LogLevel::LEVEL_ERROR, "http failed to open recording");
+        return false;
+      }
+    }
+
+    /* Nothing to read past the end of the file */
+    const int64_t length = m_file.GetLength();
+    if (length >= 0 && offset >= length)
+      return true;
+
+    if (m_file.Seek(offset, SEEK_SET) != offset)
+    {
+      Logger::Log(LogLevel::LEVEL_ERROR, "http failed to seek to %lld",
+                  static_cast<long long>(offset));
+      m_file.Close();
+      m_open = false;
+      return false;
+    }
+
+    data.resize(size);
+    size_t read = 0;
+    while (read < size)
+    {
+      const ssize_t ret = m_file.Read(data.data() + read, size - read);
+      if (ret < 0)
+      {
+        Logger::Log(LogLevel::LEVEL_ERROR, "http failed to read at %lld",
+                    static_cast<long long>(offset + read));
+        m_file.Close();
+        m_open = false;
+        return false;
+      }
+      else if (ret == 0)
+        break;
+
+      read += static_cast<size_t>(ret);
+    }
+
+    data.resize(read);
+    return true;
+  }
+
+  HTTPRangeReader& m_reader;
+  kodi::vfs::CFile m_file;
+  bool m_open = false;
+};
+
+HTTPRangeReader::HTTPRangeReader(const std::string& url, size_t connections) : m_url(url)
+{
+  for (size_t i = 0; i < connections; ++i)
+    m_workers.emplace_back(new Worker(*this));
+}
+
+HTTPRangeReader::~HTTPRangeReader()
+{
+  std::deque<Request> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    cancelled.swap(m_requests);
+  }
+  m_condition.notify_all();
+
+  for (auto& request : cancelled)
+    request.handler(nullptr);
+
+  /* Waits for the reads in progress */
+  m_workers.clear();
+}
+
+uint32_t HTTPRangeReader::Read(int64_t offset, size_t size, Handler handler)
+{
+  uint32_t id = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    id = m_nextId++;
+    if (m_nextId == 0)
+      m_nextId = 1;
+
+    m_requests.push_back({id, offset, size, std::move(handler)});
+  }
+  m_condition.notify_one();
+  return id;
+}
+
+void HTTPRangeReader::Cancel(uint32_t id)
+{
+  Handler handler;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto it = std::find_if(m_requests.begin(), m_requests.end(),
+                                 [id](const Request& request) { return request.id == id; });
+    if (it == m_requests.end())
+      return;
+
+    handler = std::move(it->handler);
+    m_requests.erase(it);
+  }
+
+  handler(nullptr);
+}
+
+bool HTTPRangeReader::Next(Request& request)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_condition.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+
+  if (m_stop)
+    return false;
+
+  request = std::move(m_requests.front());
+  m_requests.pop_front();
+  return true;
+}
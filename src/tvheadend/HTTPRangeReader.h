@@ -0,0 +1,90 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tvheadend
+{
+
+/*
+ * Reads ranges of a file over HTTP, e.g. a recording from tvheadend's /dvrfile/<id>. Each of the
+ * reader's threads has a connection of its own, so several ranges are read in parallel.
+ */
+class HTTPRangeReader
+{
+public:
+  /**
+   * Receives the data read or nullptr on failure. The data is short at the end of the file.
+   */
+  typedef std::function<void(std::vector<uint8_t>* data)> Handler;
+
+  /**
+   * @param url the file to read, any URL Kodi's VFS can seek in
+   * @param connections the number of reads to do in parallel
+   */
+  HTTPRangeReader(const std::string& url, size_t connections);
+  ~HTTPRangeReader();
+
+  HTTPRangeReader(const HTTPRangeReader&) = delete;
+  HTTPRangeReader& operator=(const HTTPRangeReader&) = delete;
+
+  /**
+   * Queues a read. The handler is invoked exactly once, from one of the reader's threads, or
+   * right away if the read is cancelled.
+   * @return the id of the read, never 0
+   */
+  uint32_t Read(int64_t offset, size_t size, Handler handler);
+
+  /**
+   * Cancels a queued read, its handler receives nullptr. Reads in progress are not interrupted.
+   * Must not be called with a lock held that the handler takes.
+   */
+  void Cancel(uint32_t id);
+
+  /**
+   * @return true once a read failed, e.g. because the server does not support ranged reads
+   */
+  bool HasFailed() const { return m_failed; }
+
+private:
+  class Worker;
+
+  struct Request
+  {
+    uint32_t id;
+    int64_t offset;
+    size_t size;
+    Handler handler;
+  };
+
+  /**
+   * Waits for the next request
+   * @return false if the reader is stopping
+   */
+  bool Next(Request& request);
+
+  const std::string m_url;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::deque<Request> m_requests;
+  uint32_t m_nextId = 1;
+  bool m_stop = false;
+  std::atomic<bool> m_failed{false};
+  std::vector<std::unique_ptr<Worker>> m_workers;
+};
+
+} // namespace tvheadend
@@ -17,6 +17,8 @@ extern "C"
 namespace tvheadend
 {
 
+struct HTSPMuxPacket;
+
 /*
  * HTSP Connection Listener interface
  */
@@ -28,6 +30,7 @@ public:
   virtual void Disconnected() = 0;
   virtual bool Connected(std::unique_lock<std::recursive_mutex>& lock) = 0;
   virtual bool ProcessMessage(const std::string& method, htsmsg_t* msg) = 0;
+  virtual void ProcessMuxPacket(const HTSPMuxPacket& pkt) = 0;
   virtual void ConnectionStateChange(const std::string& connectionString,
                                      PVR_CONNECTION_STATE newState,
                                      const std::string& message) = 0;
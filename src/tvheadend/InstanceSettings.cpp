@@ -27,6 +27,7 @@ const std::string DEFAULT_WOL_MAC = "";
 const int DEFAULT_CONNECT_TIMEOUT = 10000; // millisecs
 const int DEFAULT_RESPONSE_TIMEOUT = 5000; // millisecs
 const bool DEFAULT_ASYNC_EPG = true;
+const int DEFAULT_EPG_STORE_SIZE = 256; // MiB
 const bool DEFAULT_PRETUNER_ENABLED = false;
 const int DEFAULT_TOTAL_TUNERS = 1; // total tuners > 1 => predictive tuning active
 const int DEFAULT_PRETUNER_CLOSEDELAY = 10; // secs
@@ -42,6 +43,7 @@ const int DEFAULT_DVR_LIFETIME = 15; // use backend setting
 const int DEFAULT_DVR_DUPDETECT = DVR_AUTOREC_RECORD_ALL;
 const bool DEFAULT_DVR_PLAYSTATUS = true;
 const int DEFAULT_STREAM_CHUNKSIZE = 64; // KB
+const bool DEFAULT_DVR_PLAYBACK_HTTP = false;
 const bool DEFAULT_DVR_IGNORE_DUPLICATE_SCHEDULES = true;
 const bool DEFAULT_STREAM_STALLED_THRESHOLD = 10; // seconds
 
@@ -59,6 +61,7 @@ InstanceSettings::InstanceSettings(kodi::addon::IAddonInstance& instance)
     m_iConnectTimeout(DEFAULT_CONNECT_TIMEOUT),
     m_iResponseTimeout(DEFAULT_RESPONSE_TIMEOUT),
     m_bAsyncEpg(DEFAULT_ASYNC_EPG),
+    m_iEpgStoreSizeMB(DEFAULT_EPG_STORE_SIZE),
     m_bPretunerEnabled(DEFAULT_PRETUNER_ENABLED),
     m_iTotalTuners(DEFAULT_TOTAL_TUNERS),
     m_iPreTunerCloseDelay(DEFAULT_PRETUNER_CLOSEDELAY),
@@ -72,6 +75,7 @@ InstanceSettings::InstanceSettings(kodi::addon::IAddonInstance& instance)
     m_iDvrDupdetect(DEFAULT_DVR_DUPDETECT),
     m_bDvrPlayStatus(DEFAULT_DVR_PLAYSTATUS),
     m_iStreamReadChunkSizeKB(DEFAULT_STREAM_CHUNKSIZE),
+    m_bDvrPlaybackHTTP(DEFAULT_DVR_PLAYBACK_HTTP),
     m_bIgnoreDuplicateSchedules(DEFAULT_DVR_IGNORE_DUPLICATE_SCHEDULES),
     m_streamStalledThreshold(DEFAULT_STREAM_STALLED_THRESHOLD)
 {
@@ -95,6 +99,7 @@ void InstanceSettings::ReadSettings()
 
   /* Data Transfer */
   SetAsyncEpg(ReadBoolSetting("epg_async", DEFAULT_ASYNC_EPG));
+  SetEpgStoreSizeMB(ReadIntSetting("epg_store_size", DEFAULT_EPG_STORE_SIZE));
 
   /* Predictive Tuning */
   m_bPretunerEnabled = ReadBoolSetting("pretuner_enabled", DEFAULT_PRETUNER_ENABLED);
@@ -124,6 +129,9 @@ void InstanceSettings::ReadSettings()
   /* Stream read chunk size */
   SetStreamReadChunkSizeKB(ReadIntSetting("stream_readchunksize", DEFAULT_STREAM_CHUNKSIZE));
 
+  /* Recording playback over HTTP */
+  SetDvrPlaybackHTTP(ReadBoolSetting("dvr_playback_http", DEFAULT_DVR_PLAYBACK_HTTP));
+
   /* Scheduled recordings */
   SetIgnoreDuplicateSchedules(
       ReadBoolSetting("dvr_ignore_duplicates", DEFAULT_DVR_IGNORE_DUPLICATE_SCHEDULES));
@@ -160,6 +168,8 @@ ADDON_STATUS InstanceSettings::SetSetting(const std::string& key,
   /* Data Transfer */
   else if (key == "epg_async")
     return SetBoolSetting(GetAsyncEpg(), value);
+  else if (key == "epg_store_size")
+    return SetIntSetting(GetEpgStoreSizeMB(), value);
   /* Predictive Tuning */
   else if (key == "pretuner_enabled")
     return SetBoolSetting(m_bPretunerEnabled, value);
@@ -207,6 +217,11 @@ ADDON_STATUS InstanceSettings::SetSetting(const std::string& key,
     return SetBoolSetting(GetDvrPlayStatus(), value);
   else if (key == "stream_readchunksize")
     return SetIntSetting(GetStreamReadChunkSize(), value);
+  else if (key == "dvr_playback_http")
+  {
+    SetDvrPlaybackHTTP(value.GetBoolean());
+    return ADDON_STATUS_OK;
+  }
   else if (key == "dvr_ignore_duplicates")
   {
     SetIgnoreDuplicateSchedules(value.GetBoolean());
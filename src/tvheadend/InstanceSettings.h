@@ -40,6 +40,7 @@ public:
   int GetConnectTimeout() const { return m_iConnectTimeout; }
   int GetResponseTimeout() const { return m_iResponseTimeout; }
   bool GetAsyncEpg() const { return m_bAsyncEpg; }
+  int GetEpgStoreSizeMB() const { return m_iEpgStoreSizeMB; }
   int GetTotalTuners() const { return m_iTotalTuners; }
   int GetPreTunerCloseDelay() const { return m_iPreTunerCloseDelay; }
   int GetAutorecApproxTime() const { return m_iAutorecApproxTime; }
@@ -52,6 +53,7 @@ public:
   int GetDvrLifetime(bool asEnum = false) const;
   bool GetDvrPlayStatus() const { return m_bDvrPlayStatus; }
   int GetStreamReadChunkSize() const { return m_iStreamReadChunkSizeKB; }
+  bool GetDvrPlaybackHTTP() const { return m_bDvrPlaybackHTTP; }
   bool GetIgnoreDuplicateSchedules() const { return m_bIgnoreDuplicateSchedules; }
   int GetStreamStalledThreshold() const { return m_streamStalledThreshold; }
 
@@ -77,6 +79,7 @@ private:
   void SetConnectTimeout(int value) { m_iConnectTimeout = value; }
   void SetResponseTimeout(int value) { m_iResponseTimeout = value; }
   void SetAsyncEpg(bool value) { m_bAsyncEpg = value; }
+  void SetEpgStoreSizeMB(int value) { m_iEpgStoreSizeMB = value; }
   void SetTotalTuners(int value) { m_iTotalTuners = value; }
   void SetPreTunerCloseDelay(int value) { m_iPreTunerCloseDelay = value; }
   void SetAutorecApproxTime(int value) { m_iAutorecApproxTime = value; }
@@ -89,6 +92,7 @@ private:
   void SetDvrDupdetect(int value) { m_iDvrDupdetect = value; }
   void SetDvrPlayStatus(bool value) { m_bDvrPlayStatus = value; }
   void SetStreamReadChunkSizeKB(int value) { m_iStreamReadChunkSizeKB = value; }
+  void SetDvrPlaybackHTTP(bool value) { m_bDvrPlaybackHTTP = value; }
   void SetIgnoreDuplicateSchedules(bool value) { m_bIgnoreDuplicateSchedules = value; }
   void SetStreamStalledThreshold(int value) { m_streamStalledThreshold = value; }
 
@@ -117,6 +121,7 @@ private:
   int m_iConnectTimeout;
   int m_iResponseTimeout;
   bool m_bAsyncEpg;
+  int m_iEpgStoreSizeMB;
   bool m_bPretunerEnabled;
   int m_iTotalTuners;
   int m_iPreTunerCloseDelay;
@@ -130,6 +135,7 @@ private:
   int m_iDvrDupdetect;
   bool m_bDvrPlayStatus;
   int m_iStreamReadChunkSizeKB;
+  bool m_bDvrPlaybackHTTP;
   bool m_bIgnoreDuplicateSchedules;
   int m_streamStalledThreshold; // seconds
 };
@@ -0,0 +1,281 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "MetadataSnapshot.h"
+
+extern "C"
+{
+#include "libhts/htsmsg_binary.h"
+}
+
+#include "HTSPConnection.h"
+#include "utilities/Logger.h"
+
+#include "kodi/Filesystem.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace tvheadend;
+using namespace tvheadend::entity;
+using namespace tvheadend::utilities;
+
+#define SNAPSHOT_VERSION (2)
+#define SNAPSHOT_MAX_SIZE (64 * 1024 * 1024) // bytes
+
+MetadataSnapshot::MetadataSnapshot(const std::string& path,
+                                   const std::string& server,
+                                   const HTSPConnection& conn)
+  : m_path(path), m_server(server), m_conn(conn)
+{
+}
+
+namespace
+{
+
+bool ReadFile(const std::string& path, std::vector<uint8_t>& data)
+{
+  kodi::vfs::CFile file;
+  if (!file.OpenFile(path, ADDON_READ_NO_CACHE))
+    return false;
+
+  const int64_t len = file.GetLength();
+  if (len <= 4 || len > SNAPSHOT_MAX_SIZE)
+    return false;
+
+  data.resize(static_cast<size_t>(len));
+  size_t pos = 0;
+  while (pos < data.size())
+  {
+    const ssize_t read = file.Read(data.data() + pos, data.size() - pos);
+    if (read <= 0)
+      return false;
+
+    pos += static_cast<size_t>(read);
+  }
+  return true;
+}
+
+bool WriteFile(const std::string& path, const void* data, size_t len)
+{
+  kodi::vfs::CFile file;
+  if (!file.OpenFileForWrite(path, true))
+    return false;
+
+  return file.Write(data, len) == static_cast<ssize_t>(len);
+}
+
+std::string GetStr(htsmsg_t* m, const char* name)
+{
+  const char* str = htsmsg_get_str(m, name);
+  return str ? str : "";
+}
+
+} // unnamed namespace
+
+bool MetadataSnapshot::Load(Channels& channels, Providers& providers, Tags& tags) const
+{
+  std::vector<uint8_t> data;
+  if (!ReadFile(m_path, data))
+    return false;
+
+  /* Skip the 4 byte length, as written by htsmsg_binary_serialize */
+  htsmsg_t* msg = htsmsg_binary_deserialize_arena(data.data() + 4, data.size() - 4);
+  if (!msg)
+  {
+    Logger::Log(LogLevel::LEVEL_ERROR, "malformed metadata snapshot %s", m_path.c_str());
+    return false;
+  }
+
+  if (htsmsg_get_u32_or_default(msg, "version", 0) != SNAPSHOT_VERSION ||
+      GetStr(msg, "server") != m_server)
+  {
+    Logger::Log(LogLevel::LEVEL_DEBUG, "ignoring metadata snapshot of another version or server");
+    htsmsg_destroy(msg);
+    return false;
+  }
+
+  Channels loadedChannels;
+  Providers loadedProviders;
+  Tags loadedTags;
+  htsmsg_field_t* f = nullptr;
+
+  htsmsg_t* l = htsmsg_get_list(msg, "channels");
+  HTSMSG_FOREACH(f, l)
+  {
+    if (f->hmf_type != HMF_MAP)
+      continue;
+
+    htsmsg_t* m = &f->hmf_msg;
+    Channel channel;
+    channel.SetId(htsmsg_get_u32_or_default(m, "id", 0));
+    channel.SetNum(htsmsg_get_u32_or_default(m, "number", 0));
+    channel.SetNumMinor(htsmsg_get_u32_or_default(m, "numberMinor", 0));
+    channel.SetType(htsmsg_get_u32_or_default(m, "type", CHANNEL_TYPE_OTHER));
+    channel.SetCaid(htsmsg_get_u32_or_default(m, "caid", 0));
+    channel.SetName(GetStr(m, "name"));
+    channel.SetIcon(LoadIcon(GetStr(m, "icon")));
+
+    int32_t providerUid = PVR_PROVIDER_INVALID_UID;
+    htsmsg_get_s32(m, "provider", &providerUid);
+    channel.SetProviderUid(providerUid);
+    loadedChannels[channel.GetId()] = channel;
+  }
+
+  l = htsmsg_get_list(msg, "providers");
+  HTSMSG_FOREACH(f, l)
+  {
+    if (f->hmf_type != HMF_MAP)
+      continue;
+
+    htsmsg_t* m = &f->hmf_msg;
+    Provider provider;
+    provider.SetId(htsmsg_get_u32_or_default(m, "id", 0));
+    provider.SetName(GetStr(m, "name"));
+    loadedProviders[provider.GetId()] = provider;
+  }
+
+  l = htsmsg_get_list(msg, "tags");
+  HTSMSG_FOREACH(f, l)
+  {
+    if (f->hmf_type != HMF_MAP)
+      continue;
+
+    htsmsg_t* m = &f->hmf_msg;
+    Tag tag;
+    tag.SetId(htsmsg_get_u32_or_default(m, "id", 0));
+    tag.SetIndex(htsmsg_get_u32_or_default(m, "index", 0));
+    tag.SetName(GetStr(m, "name"));
+    tag.SetIcon(LoadIcon(GetStr(m, "icon")));
+
+    htsmsg_t* members = htsmsg_get_list(m, "members");
+    htsmsg_field_t* member = nullptr;
+    HTSMSG_FOREACH(member, members)
+    {
+      if (member->hmf_type == HMF_S64)
+        tag.GetChannels().emplace_back(static_cast<uint32_t>(member->hmf_s64));
+    }
+    loadedTags[tag.GetId()] = tag;
+  }
+
+  htsmsg_destroy(msg);
+
+  channels.swap(loadedChannels);
+  providers.swap(loadedProviders);
+  tags.swap(loadedTags);
+
+  Logger::Log(LogLevel::LEVEL_INFO,
+              "metadata snapshot loaded (%zu channels, %zu providers, %zu tags)", channels.size(),
+              providers.size(), tags.size());
+  return true;
+}
+
+bool MetadataSnapshot::Save(const Channels& channels,
+                            const Providers& providers,
+                            const Tags& tags) const
+{
+  htsmsg_t* msg = htsmsg_create_map();
+  htsmsg_add_u32(msg, "version", SNAPSHOT_VERSION);
+  htsmsg_add_str(msg, "server", m_server.c_str());
+
+  htsmsg_t* l = htsmsg_create_list();
+  for (const auto& entry : channels)
+  {
+    const Channel& channel = entry.second;
+    htsmsg_t* m = htsmsg_create_map();
+    htsmsg_add_u32(m, "id", channel.GetId());
+    htsmsg_add_u32(m, "number", channel.GetNum());
+    htsmsg_add_u32(m, "numberMinor", channel.GetNumMinor());
+    htsmsg_add_u32(m, "type", channel.GetType());
+    htsmsg_add_u32(m, "caid", channel.GetCaid());
+    htsmsg_add_str(m, "name", channel.GetName().c_str());
+    htsmsg_add_str(m, "icon", SaveIcon(channel.GetIcon()).c_str());
+    htsmsg_add_s32(m, "provider", channel.GetProviderUid());
+    htsmsg_add_msg(l, nullptr, m);
+  }
+  htsmsg_add_msg(msg, "channels", l);
+
+  l = htsmsg_create_list();
+  for (const auto& entry : providers)
+  {
+    htsmsg_t* m = htsmsg_create_map();
+    htsmsg_add_u32(m, "id", entry.second.GetId());
+    htsmsg_add_str(m, "name", entry.second.GetName().c_str());
+    htsmsg_add_msg(l, nullptr, m);
+  }
+  htsmsg_add_msg(msg, "providers", l);
+
+  l = htsmsg_create_list();
+  for (const auto& entry : tags)
+  {
+    const Tag& tag = entry.second;
+    htsmsg_t* m = htsmsg_create_map();
+    htsmsg_add_u32(m, "id", tag.GetId());
+    htsmsg_add_u32(m, "index", tag.GetIndex());
+    htsmsg_add_str(m, "name", tag.GetName().c_str());
+    htsmsg_add_str(m, "icon", SaveIcon(tag.GetIcon()).c_str());
+
+    htsmsg_t* members = htsmsg_create_list();
+    for (uint32_t channelId : tag.GetChannels())
+      htsmsg_add_u32(members, nullptr, channelId);
+    htsmsg_add_msg(m, "members", members);
+
+    htsmsg_add_msg(l, nullptr, m);
+  }
+  htsmsg_add_msg(msg, "tags", l);
+
+  void* data = nullptr;
+  size_t len = 0;
+  const int ret = htsmsg_binary_serialize(msg, &data, &len, -1);
+  htsmsg_destroy(msg);
+  if (ret != 0)
+    return false;
+
+  /* Write to a temporary file first, so a crash never leaves a partial snapshot behind */
+  const std::string tmpPath = m_path + ".tmp";
+  bool success = WriteFile(tmpPath, data, len);
+  std::free(data);
+
+  if (success)
+  {
+    if (kodi::vfs::FileExists(m_path))
+      kodi::vfs::DeleteFile(m_path);
+
+    success = kodi::vfs::RenameFile(tmpPath, m_path);
+  }
+
+  if (!success)
+    Logger::Log(LogLevel::LEVEL_ERROR, "failed to write metadata snapshot %s", m_path.c_str());
+
+  return success;
+}
+
+std::string MetadataSnapshot::SaveIcon(const std::string& icon) const
+{
+  std::string url = m_conn.GetWebPath(icon);
+
+  /* Drop the credentials of any other URL too */
+  const size_t host = url.find("://");
+  if (host != std::string::npos)
+  {
+    const size_t path = url.find('/', host + 3);
+    const size_t auth = url.rfind('@', path);
+    if (auth != std::string::npos && auth > host)
+      url.erase(host + 3, auth + 1 - (host + 3));
+  }
+
+  return url;
+}
+
+std::string MetadataSnapshot::LoadIcon(const std::string& icon) const
+{
+  if (icon.empty() || icon[0] != '/')
+    return icon;
+
+  return m_conn.GetWebURL(icon.c_str());
+}
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "entity/Channel.h"
+#include "entity/Provider.h"
+#include "entity/Tag.h"
+
+#include <string>
+
+namespace tvheadend
+{
+
+class HTSPConnection;
+
+/*
+ * On-disk copy of the channel list (channels, providers and tags), so Kodi can be served right
+ * after startup, before the initial sync with the server completed. The snapshot is stored as a
+ * single binary htsmsg. Icons on the server are stored as paths, so that the credentials in their
+ * URLs are never written to disk.
+ */
+class MetadataSnapshot
+{
+public:
+  /**
+   * @param path the snapshot file
+   * @param server identifies the server, a snapshot of another server is ignored
+   * @param conn the connection, to build the URLs of the icons on the server
+   */
+  MetadataSnapshot(const std::string& path,
+                   const std::string& server,
+                   const HTSPConnection& conn);
+
+  /**
+   * Reads the snapshot. The entities are only changed if the snapshot could be read completely.
+   * @return true if the snapshot was read
+   */
+  bool Load(entity::Channels& channels, entity::Providers& providers, entity::Tags& tags) const;
+
+  /**
+   * Replaces the snapshot
+   * @return true if the snapshot was written
+   */
+  bool Save(const entity::Channels& channels,
+            const entity::Providers& providers,
+            const entity::Tags& tags) const;
+
+private:
+  std::string SaveIcon(const std::string& icon) const;
+  std::string LoadIcon(const std::string& icon) const;
+
+  const std::string m_path;
+  const std::string m_server;
+  const HTSPConnection& m_conn;
+};
+
+} // namespace tvheadend
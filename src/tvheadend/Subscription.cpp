@@ -13,17 +13,19 @@
 #include "kodi/General.h"
 
 #include <cstring>
+#include <utility>
 
 using namespace tvheadend;
 using namespace tvheadend::utilities;
 
-Subscription::Subscription(HTSPConnection& conn)
+Subscription::Subscription(HTSPConnection& conn, std::function<void(uint32_t id)> idChanged)
   : m_id(0),
     m_channelId(0),
     m_weight(SUBSCRIPTION_WEIGHT_NORMAL),
     m_speed(1000),
     m_state(SUBSCRIPTION_STOPPED),
-    m_conn(conn)
+    m_conn(conn),
+    m_idChanged(std::move(idChanged))
 {
 }
 
@@ -43,6 +45,9 @@ void Subscription::SetId(uint32_t id)
 {
   std::lock_guard<std::recursive_mutex> lock(m_mutex);
   m_id = id;
+
+  if (m_idChanged)
+    m_idChanged(id);
 }
 
 uint32_t Subscription::GetChannelId() const
@@ -105,6 +110,23 @@ void Subscription::SetProfile(const std::string& profile)
   m_profile = profile;
 }
 
+htsmsg_t* Subscription::CreateSubscribeMessage()
+{
+  htsmsg_t* m = htsmsg_create_map();
+  htsmsg_add_s32(m, "channelId", GetChannelId());
+  htsmsg_add_u32(m, "subscriptionId", GetId());
+  htsmsg_add_u32(m, "weight", GetWeight());
+  htsmsg_add_u32(m, "timeshiftPeriod", static_cast<uint32_t>(~0));
+  htsmsg_add_u32(m, "normts", 1);
+  htsmsg_add_u32(m, "queueDepth", PACKET_QUEUE_DEPTH);
+
+  /* Use the specified profile if it has been set */
+  if (!GetProfile().empty())
+    htsmsg_add_str(m, "profile", GetProfile().c_str());
+
+  return m;
+}
+
 void Subscription::SendSubscribe(std::unique_lock<std::recursive_mutex>& lock,
                                  uint32_t channelId,
                                  uint32_t weight,
@@ -120,17 +142,7 @@ void Subscription::SendSubscribe(std::unique_lock<std::recursive_mutex>& lock,
   }
 
   /* Build message */
-  htsmsg_t* m = htsmsg_create_map();
-  htsmsg_add_s32(m, "channelId", GetChannelId());
-  htsmsg_add_u32(m, "subscriptionId", GetId());
-  htsmsg_add_u32(m, "weight", GetWeight());
-  htsmsg_add_u32(m, "timeshiftPeriod", static_cast<uint32_t>(~0));
-  htsmsg_add_u32(m, "normts", 1);
-  htsmsg_add_u32(m, "queueDepth", PACKET_QUEUE_DEPTH);
-
-  /* Use the specified profile if it has been set */
-  if (!GetProfile().empty())
-    htsmsg_add_str(m, "profile", GetProfile().c_str());
+  htsmsg_t* m = CreateSubscribeMessage();
 
   Logger::Log(LogLevel::LEVEL_DEBUG, "demux subscribe to %d", GetChannelId());
 
@@ -150,25 +162,85 @@ void Subscription::SendSubscribe(std::unique_lock<std::recursive_mutex>& lock,
               GetId());
 }
 
-void Subscription::SendUnsubscribe(std::unique_lock<std::recursive_mutex>& lock)
+void Subscription::SendSubscribeAsync(uint32_t channelId,
+                                      uint32_t weight,
+                                      bool restart,
+                                      std::function<void()> failed)
 {
+  /* We don't want to change anything when restarting a subscription */
+  if (!restart)
+  {
+    SetChannelId(channelId);
+    SetWeight(weight);
+    SetId(GetNextId());
+    SetSpeed(1000); //set back to normal
+  }
+
+  /* Considered active right away, packets may arrive before the response */
+  SetState(SUBSCRIPTION_STARTING);
+
+  /* While reconnecting the subscription stays active, RebuildState subscribes once registered */
+  std::lock_guard<std::recursive_mutex> connLock(m_conn.Mutex());
+  if (!m_conn.IsReady())
+  {
+    Logger::Log(LogLevel::LEVEL_DEBUG, "demux subscribe to %d deferred until connected",
+                GetChannelId());
+    return;
+  }
+
   /* Build message */
-  htsmsg_t* m = htsmsg_create_map();
-  htsmsg_add_u32(m, "subscriptionId", GetId());
-  Logger::Log(LogLevel::LEVEL_DEBUG, "demux unsubscribe from %d", GetChannelId());
+  htsmsg_t* m = CreateSubscribeMessage();
+
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux subscribe to %d", GetChannelId());
+
+  /* Send, the response is handled on the connection thread */
+  const uint32_t id = GetId();
+  m_conn.SendAsync("subscribe", m, [this, channelId = GetChannelId(), id, failed](htsmsg_t* msg) {
+    if (msg)
+    {
+      htsmsg_destroy(msg);
+      Logger::Log(LogLevel::LEVEL_DEBUG,
+                  "demux successfully subscribed to channel id %d, subscription id %d", channelId,
+                  id);
+      return;
+    }
+
+    Logger::Log(LogLevel::LEVEL_ERROR,
+                "demux failed to subscribe to channel id %d, subscription id %d", channelId, id);
+
+    /* The caller decides what a failed restart means */
+    if (failed)
+    {
+      failed();
+      return;
+    }
+
+    /* Unless the subscription has been replaced meanwhile */
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    if (GetId() == id)
+      SetState(SUBSCRIPTION_STOPPED);
+  });
+}
+
+void Subscription::SendUnsubscribe()
+{
+  const uint32_t id = GetId();
+  const uint32_t channelId = GetChannelId();
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux unsubscribe from %d", channelId);
 
   /* Mark subscription as inactive immediately in case this command fails */
   SetState(SUBSCRIPTION_STOPPED);
 
-  /* Send and Wait */
-  m = m_conn.SendAndWait(lock, "unsubscribe", m);
-  if (!m)
-    return;
+  /* Send, nothing depends on the response */
+  m_conn.SendAsync("unsubscribe", {{"subscriptionId", id}}, [channelId, id](htsmsg_t* msg) {
+    if (!msg)
+      return;
 
-  htsmsg_destroy(m);
-  Logger::Log(LogLevel::LEVEL_DEBUG,
-              "demux successfully unsubscribed from channel id %d, subscription id %d",
-              GetChannelId(), GetId());
+    htsmsg_destroy(msg);
+    Logger::Log(LogLevel::LEVEL_DEBUG,
+                "demux successfully unsubscribed from channel id %d, subscription id %d",
+                channelId, id);
+  });
 }
 
 bool Subscription::SendSeek(std::unique_lock<std::recursive_mutex>& lock, double time)
@@ -198,35 +270,51 @@ void Subscription::SendSpeed(std::unique_lock<std::recursive_mutex>& lock,
     SetSpeed(speed);
 
   /* Build message */
-  htsmsg_t* m = htsmsg_create_map();
-  htsmsg_add_u32(m, "subscriptionId", GetId());
-  htsmsg_add_s32(m, "speed",
-                 GetSpeed() / 10); // Kodi uses values an order of magnitude larger than tvheadend
-  Logger::Log(LogLevel::LEVEL_DEBUG, "demux send speed %d", GetSpeed() / 10);
+  const int32_t tvhSpeed =
+      GetSpeed() / 10; // Kodi uses values an order of magnitude larger than tvheadend
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux send speed %d", tvhSpeed);
 
+  htsmsg_t* m = nullptr;
   if (restart)
-    m = m_conn.SendAndWait0(lock, "subscriptionSpeed", m);
+    m = m_conn.SendAndWait0(lock, "subscriptionSpeed",
+                            {{"subscriptionId", GetId()}, {"speed", tvhSpeed}});
   else
-    m = m_conn.SendAndWait(lock, "subscriptionSpeed", m);
+    m = m_conn.SendAndWait(lock, "subscriptionSpeed",
+                           {{"subscriptionId", GetId()}, {"speed", tvhSpeed}});
 
   if (m)
     htsmsg_destroy(m);
 }
 
-void Subscription::SendWeight(std::unique_lock<std::recursive_mutex>& lock, uint32_t weight)
+void Subscription::SendSpeedAsync(int32_t speed, bool temporary)
 {
-  SetWeight(weight);
+  if (!temporary)
+    SetSpeed(speed);
 
-  /* Build message */
-  htsmsg_t* m = htsmsg_create_map();
-  htsmsg_add_u32(m, "subscriptionId", GetId());
-  htsmsg_add_s32(m, "weight", GetWeight());
-  Logger::Log(LogLevel::LEVEL_DEBUG, "demux send weight %u", GetWeight());
+  const int32_t tvhSpeed =
+      speed / 10; // Kodi uses values an order of magnitude larger than tvheadend
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux send speed %d", tvhSpeed);
 
-  /* Send and Wait */
-  m = m_conn.SendAndWait(lock, "subscriptionChangeWeight", m);
-  if (m)
-    htsmsg_destroy(m);
+  /* Send, errors are announced by the connection */
+  m_conn.SendAsync("subscriptionSpeed", {{"subscriptionId", GetId()}, {"speed", tvhSpeed}},
+                   [](htsmsg_t* msg) {
+                     if (msg)
+                       htsmsg_destroy(msg);
+                   });
+}
+
+void Subscription::SendWeight(uint32_t weight)
+{
+  SetWeight(weight);
+  Logger::Log(LogLevel::LEVEL_DEBUG, "demux send weight %u", weight);
+
+  /* Send, errors are announced by the connection */
+  m_conn.SendAsync("subscriptionChangeWeight",
+                   {{"subscriptionId", GetId()}, {"weight", static_cast<int32_t>(weight)}},
+                   [](htsmsg_t* msg) {
+                     if (msg)
+                       htsmsg_destroy(msg);
+                   });
 }
 
 void Subscription::ParseSubscriptionStatus(htsmsg_t* m)
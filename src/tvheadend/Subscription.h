@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <functional>
 #include <mutex>
 #include <string>
 
@@ -54,7 +55,11 @@ static const int PACKET_QUEUE_DEPTH = 10000000;
 class Subscription
 {
 public:
-  Subscription(HTSPConnection& conn);
+  /**
+   * @param conn the connection
+   * @param idChanged called whenever the subscription gets a new id, before it is sent
+   */
+  Subscription(HTSPConnection& conn, std::function<void(uint32_t id)> idChanged = nullptr);
 
   bool IsActive() const;
   uint32_t GetId() const;
@@ -76,9 +81,22 @@ public:
                      bool restart = false);
 
   /**
-   * Unsubscribe from a channel on the backend
+   * Subscribe to a channel on the backend without waiting for the response. The subscription is
+   * active right away and stopped again if the backend rejects it.
+   * @param channelId the channel to subscribe to
+   * @param weight the desired subscription weight
+   * @param restart restart the current subscription, channelId and weight will be ignored
+   * @param failed called instead of stopping the subscription if the backend rejects it
+   */
+  void SendSubscribeAsync(uint32_t channelId,
+                          uint32_t weight,
+                          bool restart = false,
+                          std::function<void()> failed = nullptr);
+
+  /**
+   * Unsubscribe from a channel on the backend, without waiting for the response
    */
-  void SendUnsubscribe(std::unique_lock<std::recursive_mutex>& lock);
+  void SendUnsubscribe();
 
   /**
    * Send a seek to the backend
@@ -95,10 +113,17 @@ public:
   void SendSpeed(std::unique_lock<std::recursive_mutex>& lock, int32_t speed, bool restart = false);
 
   /**
-   * Change the subscription weight on the backend
+   * Change the subscription speed on the backend, without waiting for the response
+   * @param speed the desired speed of the subscription
+   * @param temporary send the speed without storing it, e.g. to pause the subscription for a while
+   */
+  void SendSpeedAsync(int32_t speed, bool temporary = false);
+
+  /**
+   * Change the subscription weight on the backend, without waiting for the response
    * @param weight the desired subscription weight
    */
-  void SendWeight(std::unique_lock<std::recursive_mutex>& lock, uint32_t weight);
+  void SendWeight(uint32_t weight);
 
   /**
    * Parse the subscription status out of the incoming htsp data
@@ -113,6 +138,8 @@ public:
   void SetProfile(const std::string& profile);
 
 private:
+  htsmsg_t* CreateSubscribeMessage();
+
   void SetId(uint32_t id);
   void SetChannelId(uint32_t id);
   void SetWeight(uint32_t weight);
@@ -136,6 +163,7 @@ private:
   eSubsriptionState m_state;
   std::string m_profile;
   HTSPConnection& m_conn;
+  std::function<void(uint32_t id)> m_idChanged;
 
   mutable std::recursive_mutex m_mutex;
 };
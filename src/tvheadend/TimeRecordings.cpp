@@ -9,6 +9,7 @@
 
 #include "CustomTimerProperties.h"
 #include "HTSPConnection.h"
+#include "HTSPSchema.h"
 #include "entity/Recording.h"
 #include "utilities/LifetimeMapper.h"
 #include "utilities/Logger.h"
@@ -230,10 +231,22 @@ PVR_ERROR TimeRecordings::SendTimerecDelete(const kodi::addon::PVRTimer& timer)
   return u32 == 1 ? PVR_ERROR_NO_ERROR : PVR_ERROR_FAILED;
 }
 
+namespace
+{
+
+/* timerecEntryAdd/timerecEntryUpdate */
+constexpr HTSPSchema TIMEREC_SCHEMA({"id", "enabled", "daysOfWeek", "removal", "priority", "start",
+                                     "stop", "title", "name", "directory", "owner", "creator",
+                                     "channel", "configId", "comment"});
+
+} // unnamed namespace
+
 bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
 {
+  const HTSPFields fields(TIMEREC_SCHEMA, msg);
+
   /* Validate/set mandatory fields */
-  const char* str = htsmsg_get_str(msg, "id");
+  const char* str = fields.GetStr("id");
   if (!str)
   {
     Logger::Log(LogLevel::LEVEL_ERROR,
@@ -249,7 +262,7 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   /* Validate/set fields mandatory for timerecEntryAdd */
 
   uint32_t u32 = 0;
-  if (!htsmsg_get_u32(msg, "enabled", &u32))
+  if (!fields.GetU32("enabled", &u32))
   {
     rec.SetEnabled(u32);
   }
@@ -259,7 +272,7 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "daysOfWeek", &u32))
+  if (!fields.GetU32("daysOfWeek", &u32))
   {
     rec.SetDaysOfWeek(u32);
   }
@@ -269,7 +282,7 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "removal", &u32))
+  if (!fields.GetU32("removal", &u32))
   {
     rec.SetLifetime(u32);
   }
@@ -279,7 +292,7 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_u32(msg, "priority", &u32))
+  if (!fields.GetU32("priority", &u32))
   {
     rec.SetPriority(u32);
   }
@@ -290,7 +303,7 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   int32_t s32 = 0;
-  if (!htsmsg_get_s32(msg, "start", &s32))
+  if (!fields.GetS32("start", &s32))
   {
     rec.SetStart(s32);
   }
@@ -300,7 +313,7 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     return false;
   }
 
-  if (!htsmsg_get_s32(msg, "stop", &s32))
+  if (!fields.GetS32("stop", &s32))
   {
     rec.SetStop(s32);
   }
@@ -311,27 +324,27 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
   }
 
   /* Add optional fields */
-  str = htsmsg_get_str(msg, "title");
+  str = fields.GetStr("title");
   if (str)
     rec.SetTitle(str);
 
-  str = htsmsg_get_str(msg, "name");
+  str = fields.GetStr("name");
   if (str)
     rec.SetName(str);
 
-  str = htsmsg_get_str(msg, "directory");
+  str = fields.GetStr("directory");
   if (str)
     rec.SetDirectory(str);
 
-  str = htsmsg_get_str(msg, "owner");
+  str = fields.GetStr("owner");
   if (str)
     rec.SetOwner(str);
 
-  str = htsmsg_get_str(msg, "creator");
+  str = fields.GetStr("creator");
   if (str)
     rec.SetCreator(str);
 
-  if (!htsmsg_get_u32(msg, "channel", &u32))
+  if (!fields.GetU32("channel", &u32))
   {
     rec.SetChannel(u32);
   }
@@ -344,11 +357,11 @@ bool TimeRecordings::ParseTimerecAddOrUpdate(htsmsg_t* msg, bool bAdd)
     rec.SetChannel(PVR_TIMER_ANY_CHANNEL);
   }
 
-  str = htsmsg_get_str(msg, "configId");
+  str = fields.GetStr("configId");
   if (str)
     rec.SetConfigUuid(str);
 
-  str = htsmsg_get_str(msg, "comment");
+  str = fields.GetStr("comment");
   if (str)
     rec.SetComment(str);
 
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "SeriesRecordingBase.h"
+#include "../utilities/InternedString.h"
 
 #include <cstdint>
 #include <map>
@@ -66,7 +67,7 @@ private:
   uint32_t m_dupDetect{0}; // duplicate episode detect (numeric values: see dvr_autorec_dedup_t).
   uint32_t m_fulltext{0}; // Fulltext epg search.
   uint32_t m_broadcastType{0}; // Broadcast type (numeric values: see dvr_autorec_btype_t).
-  std::string m_seriesLink; // Series link.
+  utilities::InternedString m_seriesLink; // Series link.
 };
 
 typedef std::map<std::string, AutoRecording> AutoRecordingsMap;
@@ -9,6 +9,7 @@
 
 #include "../HTSPTypes.h"
 #include "Entity.h"
+#include "../utilities/InternedString.h"
 
 #include <cstdint>
 #include <map>
@@ -68,7 +69,7 @@ private:
   uint32_t m_numMinor;
   uint32_t m_type;
   uint32_t m_caid;
-  std::string m_name;
+  utilities::InternedString m_name;
   std::string m_icon;
   int32_t m_providerUid{PVR_PROVIDER_INVALID_UID};
 };
@@ -46,6 +46,6 @@ void Event::SetAired(time_t aired)
   }
   else
   {
-    m_aired.clear();
+    m_aired = utilities::InternedString();
   }
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "Entity.h"
+#include "../utilities/InternedString.h"
 
 #include <cstdint>
 #include <map>
@@ -130,18 +131,23 @@ public:
 
   const std::string& GetWriters() const { return m_writers; }
   void SetWriters(const std::vector<std::string>& writers);
+  void SetWriters(const std::string& writers) { m_writers = writers; }
 
   const std::string& GetDirectors() const { return m_directors; }
   void SetDirectors(const std::vector<std::string>& directors);
+  void SetDirectors(const std::string& directors) { m_directors = directors; }
 
   const std::string& GetCast() const { return m_cast; }
   void SetCast(const std::vector<std::string>& cast);
+  void SetCast(const std::string& cast) { m_cast = cast; }
 
   const std::string& GetCategories() const { return m_categories; }
   void SetCategories(const std::vector<std::string>& categories);
+  void SetCategories(const std::string& categories) { m_categories = categories; }
 
   const std::string& GetAired() const { return m_aired; }
   void SetAired(time_t aired);
+  void SetAired(const std::string& aired) { m_aired = aired; }
 
 private:
   uint32_t m_next;
@@ -154,22 +160,22 @@ private:
   int32_t m_season;
   int32_t m_episode;
   uint32_t m_part;
-  std::string m_title;
+  utilities::InternedString m_title;
   std::string m_subtitle; /* episode name */
   std::string m_desc;
   std::string m_summary;
   std::string m_image;
   uint32_t m_recordingId;
-  std::string m_seriesLink;
+  utilities::InternedString m_seriesLink;
   uint32_t m_year;
-  std::string m_writers;
-  std::string m_directors;
-  std::string m_cast;
-  std::string m_categories;
-  std::string m_aired;
-  std::string m_ratingLabel; // Label like 'PG' or 'FSK 12'
-  std::string m_ratingIcon; // Path to graphic for the above label.
-  std::string m_ratingSource; // Parental rating source.
+  utilities::InternedString m_writers;
+  utilities::InternedString m_directors;
+  utilities::InternedString m_cast;
+  utilities::InternedString m_categories;
+  utilities::InternedString m_aired;
+  utilities::InternedString m_ratingLabel; // Label like 'PG' or 'FSK 12'
+  utilities::InternedString m_ratingIcon; // Path to graphic for the above label.
+  utilities::InternedString m_ratingSource; // Parental rating source.
 };
 
 } // namespace entity
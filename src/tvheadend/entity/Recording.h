@@ -8,6 +8,7 @@
 #pragma once
 
 #include "RecordingBase.h"
+#include "../utilities/InternedString.h"
 
 #include "kodi/addon-instance/pvr/Timers.h"
 
@@ -187,7 +188,7 @@ public:
 
 private:
   uint32_t m_channelType{0};
-  std::string m_channelName;
+  utilities::InternedString m_channelName;
   uint32_t m_eventId{0};
   int64_t m_start{0};
   int64_t m_stop{0};
@@ -201,10 +202,10 @@ private:
   std::string m_description;
   std::string m_image;
   std::string m_fanartImage;
-  std::string m_timerecId;
-  std::string m_autorecId;
+  utilities::InternedString m_timerecId;
+  utilities::InternedString m_autorecId;
   PVR_TIMER_STATE m_state{PVR_TIMER_STATE_ERROR};
-  std::string m_error;
+  utilities::InternedString m_error;
   uint32_t m_playCount{0};
   uint32_t m_playPosition{0};
   uint32_t m_contentType{0};
@@ -212,9 +213,9 @@ private:
   int32_t m_episode{-1};
   uint32_t m_part{0};
   uint32_t m_ageRating{0};
-  std::string m_ratingLabel;
-  std::string m_ratingIcon;
-  std::string m_ratingSource;
+  utilities::InternedString m_ratingLabel;
+  utilities::InternedString m_ratingIcon;
+  utilities::InternedString m_ratingSource;
 };
 
 } // namespace tvheadend::entity
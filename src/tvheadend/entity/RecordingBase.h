@@ -9,6 +9,7 @@
 
 #include "../HTSPTypes.h"
 #include "Entity.h"
+#include "../utilities/InternedString.h"
 
 #include <cstdint>
 #include <string>
@@ -59,7 +60,7 @@ private:
   uint32_t m_priority{DVR_PRIO_DEFAULT}; // Priority.
   std::string m_title; // Title (pattern) for the recording files.
   uint32_t m_channel{0}; // Channel ID.
-  std::string m_configUuid; // DVR configuration UUID.
+  utilities::InternedString m_configUuid; // DVR configuration UUID.
   std::string m_comment; // user supplied comment
 };
 
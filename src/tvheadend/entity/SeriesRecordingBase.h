@@ -8,6 +8,7 @@
 #pragma once
 
 #include "RecordingBase.h"
+#include "../utilities/InternedString.h"
 
 #include <cstdint>
 #include <ctime>
@@ -59,8 +60,8 @@ private:
       0}; // Bitmask - Days of week (0x01 = Monday, 0x40 = Sunday, 0x7f = Whole Week, 0 = Not set).
   std::string m_name; // Name.
   std::string m_directory; // Directory for the recording files.
-  std::string m_owner; // Owner.
-  std::string m_creator; // Creator.
+  utilities::InternedString m_owner; // Owner.
+  utilities::InternedString m_creator; // Creator.
 };
 
 } // namespace tvheadend::entity
@@ -45,6 +45,11 @@ void Tag::SetName(const std::string& name)
   m_name = name;
 }
 
+const std::string& Tag::GetIcon() const
+{
+  return m_icon;
+}
+
 void Tag::SetIcon(const std::string& icon)
 {
   m_icon = icon;
@@ -42,6 +42,7 @@ public:
   const std::string& GetName() const;
   void SetName(const std::string& name);
 
+  const std::string& GetIcon() const;
   void SetIcon(const std::string& icon);
 
   const std::vector<uint32_t>& GetChannels() const;
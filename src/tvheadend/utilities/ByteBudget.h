@@ -0,0 +1,48 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace tvheadend
+{
+namespace utilities
+{
+
+/*
+ * Thread safe accounting of buffered bytes against a limit
+ */
+class ByteBudget
+{
+public:
+  ByteBudget(size_t limit) : m_limit(limit) {}
+
+  void Acquire(size_t bytes) { m_used += bytes; }
+  void Release(size_t bytes) { m_used -= bytes; }
+
+  size_t GetUsed() const { return m_used; }
+  size_t GetLimit() const { return m_limit; }
+
+  /**
+   * @return true if more bytes are in use than the limit allows
+   */
+  bool IsExceeded() const { return m_used > m_limit; }
+
+  /**
+   * @return true if at most half of the limit is in use
+   */
+  bool IsBelowLowWatermark() const { return m_used <= m_limit / 2; }
+
+private:
+  std::atomic<size_t> m_used{0};
+  const size_t m_limit;
+};
+
+} // namespace utilities
+} // namespace tvheadend
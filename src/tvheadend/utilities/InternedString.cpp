@@ -0,0 +1,92 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "InternedString.h"
+
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+using namespace tvheadend::utilities;
+
+struct InternedString::Pool
+{
+  std::mutex mutex;
+  std::unordered_map<std::string_view, Entry*> entries; // keys refer to the pooled strings
+};
+
+InternedString::Pool& InternedString::GetPool()
+{
+  /* Never destroyed, strings may outlive static destruction */
+  static Pool* pool = new Pool;
+  return *pool;
+}
+
+InternedString::Entry* InternedString::Intern(const std::string& str)
+{
+  if (str.empty())
+    return nullptr;
+
+  Pool& pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+
+  const auto it = pool.entries.find(str);
+  if (it != pool.entries.end())
+  {
+    Entry* entry = it->second;
+    ++entry->refs;
+    return entry;
+  }
+
+  Entry* entry = new Entry{str, {1}};
+  pool.entries.emplace(entry->str, entry);
+  return entry;
+}
+
+void InternedString::AddRef(Entry* entry)
+{
+  if (entry)
+    ++entry->refs;
+}
+
+void InternedString::Release(Entry* entry)
+{
+  if (!entry)
+    return;
+
+  /* Other references can only be added by the holder of one or under the pool's lock, so the
+   * last reference is only dropped under the lock, where no new one can be taken meanwhile */
+  uint32_t refs = entry->refs;
+  while (refs > 1)
+  {
+    if (entry->refs.compare_exchange_weak(refs, refs - 1))
+      return;
+  }
+
+  Pool& pool = GetPool();
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if (--entry->refs > 0)
+      return;
+
+    pool.entries.erase(entry->str);
+  }
+  delete entry;
+}
+
+const std::string& InternedString::Empty()
+{
+  static const std::string empty;
+  return empty;
+}
+
+size_t InternedString::GetPoolSize()
+{
+  Pool& pool = GetPool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  return pool.entries.size();
+}
@@ -0,0 +1,85 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace tvheadend
+{
+namespace utilities
+{
+
+/**
+ * Immutable string shared by all equal values, for entity fields that repeat a lot (categories,
+ * credits, channel names, ...). The shared strings are reference counted and removed from the
+ * pool with their last reference. An instance is the size of a pointer. This class is thread-safe.
+ */
+class InternedString
+{
+public:
+  InternedString() = default;
+  InternedString(const std::string& str) : m_entry(Intern(str)) {}
+  InternedString(const InternedString& other) : m_entry(other.m_entry) { AddRef(m_entry); }
+  InternedString(InternedString&& other) noexcept : m_entry(other.m_entry)
+  {
+    other.m_entry = nullptr;
+  }
+  ~InternedString() { Release(m_entry); }
+
+  InternedString& operator=(InternedString right) noexcept
+  {
+    std::swap(m_entry, right.m_entry);
+    return *this;
+  }
+
+  InternedString& operator=(const std::string& str)
+  {
+    Entry* entry = Intern(str);
+    Release(m_entry);
+    m_entry = entry;
+    return *this;
+  }
+
+  /* Equal strings share the same instance */
+  bool operator==(const InternedString& right) const { return m_entry == right.m_entry; }
+  bool operator!=(const InternedString& right) const { return m_entry != right.m_entry; }
+
+  const std::string& Get() const { return m_entry ? m_entry->str : Empty(); }
+  operator const std::string&() const { return Get(); }
+
+  bool empty() const { return !m_entry; }
+  const char* c_str() const { return Get().c_str(); }
+
+  /**
+   * @return the number of strings currently in the pool
+   */
+  static size_t GetPoolSize();
+
+private:
+  struct Entry
+  {
+    const std::string str;
+    std::atomic<uint32_t> refs;
+  };
+
+  struct Pool;
+
+  static Pool& GetPool();
+  static Entry* Intern(const std::string& str);
+  static void AddRef(Entry* entry);
+  static void Release(Entry* entry);
+  static const std::string& Empty();
+
+  Entry* m_entry = nullptr; // nullptr for the empty string
+};
+
+} // namespace utilities
+} // namespace tvheadend
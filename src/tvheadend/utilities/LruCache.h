@@ -0,0 +1,119 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace tvheadend
+{
+namespace utilities
+{
+
+/*
+ * Least recently used cache with a size limit. The size of an entry is given by the caller, e.g.
+ * its number of bytes. Not thread safe.
+ */
+template<typename K, typename V>
+class LruCache
+{
+public:
+  /**
+   * @param maxSize the maximum total size of the entries
+   */
+  LruCache(size_t maxSize) : m_maxSize(maxSize) {}
+
+  /**
+   * Adds or replaces an entry, evicting the least recently used entries if needed
+   */
+  void Put(const K& key, V value, size_t size)
+  {
+    Remove(key);
+
+    m_entries.push_front({key, std::move(value), size});
+    m_index[key] = m_entries.begin();
+    m_size += size;
+
+    while (m_size > m_maxSize && m_entries.size() > 1)
+    {
+      m_size -= m_entries.back().size;
+      m_index.erase(m_entries.back().key);
+      m_entries.pop_back();
+    }
+  }
+
+  /**
+   * Looks up an entry and marks it as most recently used. Counts as hit or miss.
+   * @return the value or nullptr
+   */
+  V* Get(const K& key)
+  {
+    const auto it = m_index.find(key);
+    if (it == m_index.end())
+    {
+      ++m_misses;
+      return nullptr;
+    }
+
+    ++m_hits;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return &it->second->value;
+  }
+
+  /**
+   * @return true if the key is cached. Neither the order nor the counters change.
+   */
+  bool Contains(const K& key) const { return m_index.find(key) != m_index.end(); }
+
+  void Remove(const K& key)
+  {
+    const auto it = m_index.find(key);
+    if (it == m_index.end())
+      return;
+
+    m_size -= it->second->size;
+    m_entries.erase(it->second);
+    m_index.erase(it);
+  }
+
+  /**
+   * Removes all entries and resets the counters
+   */
+  void Clear()
+  {
+    m_entries.clear();
+    m_index.clear();
+    m_size = 0;
+    m_hits = 0;
+    m_misses = 0;
+  }
+
+  size_t GetSize() const { return m_size; }
+  size_t GetHits() const { return m_hits; }
+  size_t GetMisses() const { return m_misses; }
+
+private:
+  struct Entry
+  {
+    K key;
+    V value;
+    size_t size;
+  };
+
+  const size_t m_maxSize;
+  std::list<Entry> m_entries; // most recently used first
+  std::unordered_map<K, typename std::list<Entry>::iterator> m_index;
+  size_t m_size = 0;
+  size_t m_hits = 0;
+  size_t m_misses = 0;
+};
+
+} // namespace utilities
+} // namespace tvheadend
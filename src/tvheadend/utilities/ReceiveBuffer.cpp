@@ -0,0 +1,60 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "ReceiveBuffer.h"
+
+#include "TCPSocket.h"
+
+#include <cstring>
+
+using namespace tvheadend::utilities;
+
+ReceiveBuffer::ReceiveBuffer(size_t iSize) : m_buffer(iSize)
+{
+}
+
+bool ReceiveBuffer::Fill(TCPSocket& socket, size_t len, uint64_t iTimeoutMs /*= 0*/)
+{
+  while (Available() < len)
+  {
+    /* Make room at the end of the buffer */
+    if (m_start + len > m_buffer.size())
+    {
+      if (m_start > 0)
+      {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_start, Available());
+        m_end -= m_start;
+        m_start = 0;
+      }
+
+      if (len > m_buffer.size())
+        m_buffer.resize(len);
+    }
+
+    /* Read as much as is available */
+    int64_t iRead = socket.ReadSome(m_buffer.data() + m_end, m_buffer.size() - m_end, iTimeoutMs);
+    if (iRead <= 0)
+      return false;
+
+    m_end += iRead;
+    m_bytesRead += iRead;
+  }
+  return true;
+}
+
+void ReceiveBuffer::Consume(size_t len)
+{
+  m_start += len;
+  if (m_start >= m_end)
+    Reset();
+}
+
+void ReceiveBuffer::Reset()
+{
+  m_start = 0;
+  m_end = 0;
+}
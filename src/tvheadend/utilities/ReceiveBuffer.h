@@ -0,0 +1,67 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tvheadend
+{
+namespace utilities
+{
+
+class TCPSocket;
+
+/*
+ * Receive buffer, filled from a socket in large chunks. Consumers take complete frames from the
+ * front, so that multiple frames can be processed per socket read.
+ */
+class ReceiveBuffer
+{
+public:
+  ReceiveBuffer(size_t iSize = 256 * 1024);
+
+  /**
+   * Make sure at least len contiguous bytes are available, reading from the socket if needed
+   * @param socket the socket to read from
+   * @param len the number of bytes required
+   * @param iTimeoutMs timeout for each socket read, 0 to wait until data arrives
+   * @return false on socket error, connection close or timeout
+   */
+  bool Fill(TCPSocket& socket, size_t len, uint64_t iTimeoutMs = 0);
+
+  /**
+   * Drop bytes from the front of the buffer
+   * @param len the number of bytes to drop
+   */
+  void Consume(size_t len);
+
+  /**
+   * Drop all buffered data
+   */
+  void Reset();
+
+  const uint8_t* Data() const { return m_buffer.data() + m_start; }
+  size_t Available() const { return m_end - m_start; }
+
+  /**
+   * @return the number of bytes read from sockets so far, may be called from any thread
+   */
+  uint64_t GetBytesRead() const { return m_bytesRead; }
+
+private:
+  std::vector<uint8_t> m_buffer;
+  size_t m_start = 0;
+  size_t m_end = 0;
+  std::atomic<uint64_t> m_bytesRead{0};
+};
+
+} // namespace utilities
+} // namespace tvheadend
@@ -0,0 +1,123 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace tvheadend
+{
+namespace utilities
+{
+
+/*
+ * Bounded lock-free queue for a single producer thread. Pop may be called from several threads
+ * (e.g. a flush from another thread than the reader). The mutex and condition variable are only
+ * used by a consumer waiting on an empty buffer and by the producer to wake it up.
+ */
+template<typename T>
+class RingBuffer
+{
+  static_assert(std::is_trivially_copyable<T>::value, "entries must be trivially copyable");
+
+public:
+  /**
+   * @param size the maximum number of entries, rounded up to a power of two
+   */
+  RingBuffer(size_t size) : m_mask(Capacity(size) - 1), m_slots(new std::atomic<T>[m_mask + 1]) {}
+
+  size_t Size() const
+  {
+    const size_t head = m_head.load(std::memory_order_acquire);
+    return m_tail.load(std::memory_order_acquire) - head;
+  }
+
+  /**
+   * Must only be called from the producer thread
+   * @param entry the entry to append
+   * @return false if the buffer is full
+   */
+  bool Push(T entry)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+      return false;
+
+    m_slots[tail & m_mask].store(entry, std::memory_order_relaxed);
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    /* Pairs with the fence in Pop, so either the consumer sees the entry or we see it waiting */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_waiting.load(std::memory_order_relaxed))
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_condition.notify_one();
+    }
+    return true;
+  }
+
+  /**
+   * @param entry receives the removed entry
+   * @param iTimeoutMs the time to wait for an entry if the buffer is empty
+   * @return false if no entry was available within the timeout
+   */
+  bool Pop(T& entry, int32_t iTimeoutMs = 0)
+  {
+    if (TryPop(entry))
+      return true;
+
+    if (iTimeoutMs == 0)
+      return false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiting.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const bool popped = m_condition.wait_for(lock, std::chrono::milliseconds(iTimeoutMs),
+                                             [this, &entry] { return TryPop(entry); });
+    m_waiting.fetch_sub(1, std::memory_order_relaxed);
+    return popped;
+  }
+
+private:
+  static size_t Capacity(size_t size)
+  {
+    size_t capacity = 1;
+    while (capacity < size)
+      capacity <<= 1;
+    return capacity;
+  }
+
+  bool TryPop(T& entry)
+  {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    while (head != m_tail.load(std::memory_order_acquire))
+    {
+      /* The slot may only be reused by the producer once head moved past it */
+      entry = m_slots[head & m_mask].load(std::memory_order_relaxed);
+      if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_release,
+                                       std::memory_order_relaxed))
+        return true;
+    }
+    return false;
+  }
+
+  const size_t m_mask;
+  std::unique_ptr<std::atomic<T>[]> m_slots;
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+  alignas(64) std::atomic<int> m_waiting{0};
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+};
+
+} // namespace utilities
+} // namespace tvheadend
@@ -0,0 +1,98 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace tvheadend
+{
+namespace utilities
+{
+
+/*
+ * Lock-free lookup of a target by its current id (e.g. the demuxer owning a subscription id). Each
+ * target has one id at a time. Ids are looked up in a direct mapped slot table; if the slot was
+ * taken by another id, the targets are scanned instead.
+ */
+template<typename T>
+class RoutingTable
+{
+public:
+  /**
+   * @param size the maximum number of targets
+   */
+  RoutingTable(size_t size) : m_size(size), m_routes(new Route[size]) {}
+
+  /**
+   * Change the id of a target. Ids are expected to be unique and non zero.
+   * @param target the target
+   * @param id the new id of the target
+   */
+  void Set(T* target, uint32_t id)
+  {
+    size_t idx = 0;
+    for (; idx < m_size; ++idx)
+    {
+      T* expected = nullptr;
+      if (m_routes[idx].target.load(std::memory_order_acquire) == target ||
+          m_routes[idx].target.compare_exchange_strong(expected, target))
+        break;
+    }
+
+    if (idx == m_size)
+      return;
+
+    m_routes[idx].id.store(id, std::memory_order_release);
+    m_slots[id & (SLOTS - 1)].store((static_cast<uint64_t>(id) << 32) | (idx + 1),
+                                    std::memory_order_release);
+  }
+
+  /**
+   * @param id the id to look up
+   * @return the target currently having this id, or nullptr
+   */
+  T* Find(uint32_t id) const
+  {
+    if (id == 0)
+      return nullptr;
+
+    const uint64_t slot = m_slots[id & (SLOTS - 1)].load(std::memory_order_acquire);
+    if ((slot >> 32) == id)
+    {
+      const Route& route = m_routes[(slot & 0xffffffff) - 1];
+      if (route.id.load(std::memory_order_acquire) == id)
+        return route.target.load(std::memory_order_relaxed);
+    }
+
+    /* Slot taken by another id, or the id is not (or no longer) in use */
+    for (size_t idx = 0; idx < m_size; ++idx)
+    {
+      if (m_routes[idx].id.load(std::memory_order_acquire) == id)
+        return m_routes[idx].target.load(std::memory_order_relaxed);
+    }
+    return nullptr;
+  }
+
+private:
+  static constexpr size_t SLOTS = 256;
+
+  struct Route
+  {
+    std::atomic<T*> target{nullptr};
+    std::atomic<uint32_t> id{0};
+  };
+
+  const size_t m_size;
+  std::unique_ptr<Route[]> m_routes;
+  std::atomic<uint64_t> m_slots[SLOTS] = {};
+};
+
+} // namespace utilities
+} // namespace tvheadend
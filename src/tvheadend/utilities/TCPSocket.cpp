@@ -12,6 +12,8 @@
 namespace
 {
 
+const uint64_t IDLE_POLL_INTERVAL = 1000; // ms
+
 uint64_t MillisecondsSinceEpoch()
 {
   const auto duration = std::chrono::system_clock::now().time_since_epoch();
@@ -147,6 +149,40 @@ int64_t TCPSocket::Read(void* data, size_t len, uint64_t iTimeoutMs /*= 0*/)
   }
 }
 
+int64_t TCPSocket::ReadSome(void* data, size_t len, uint64_t iTimeoutMs /*= 0*/)
+{
+  auto socket = GetSocket();
+  if (!socket)
+    return -1;
+
+  try
+  {
+    while (true)
+    {
+      const auto [iReadResult, status] =
+          socket->recv(static_cast<std::byte*>(data), len, false /* no wait */);
+
+      if (status.value == kissnet::socket_status::valid)
+        return iReadResult;
+
+      if (status.value != kissnet::socket_status::non_blocking_would_have_blocked)
+        return -1; // error or connection closed
+
+      const kissnet::socket_status selectStatus =
+          socket->select(kissnet::fds_read, iTimeoutMs > 0 ? iTimeoutMs : IDLE_POLL_INTERVAL);
+
+      if (selectStatus.value == kissnet::socket_status::errored)
+        return -1;
+      else if (selectStatus.value == kissnet::socket_status::timed_out && iTimeoutMs > 0)
+        return 0;
+    }
+  }
+  catch (std::runtime_error const&)
+  {
+    return -1;
+  }
+}
+
 int64_t TCPSocket::Write(void* data, size_t len)
 {
   auto socket = GetSocket();
@@ -33,6 +33,15 @@ public:
 
   int64_t Read(void* data, size_t len, uint64_t iTimeoutMs = 0);
 
+  /**
+   * Read whatever is available, up to len bytes. Waits only if no data is available at all.
+   * @param data the buffer to read into
+   * @param len the size of the buffer
+   * @param iTimeoutMs how long to wait for data, 0 to wait until data arrives
+   * @return the number of bytes read, 0 on timeout, -1 on error or connection close
+   */
+  int64_t ReadSome(void* data, size_t len, uint64_t iTimeoutMs = 0);
+
   int64_t Write(void* data, size_t len);
 
 private:
@@ -0,0 +1,87 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+/*
+ * Measures the resident memory of a synthetic EPG of 500k events, with 4000 series, 6 categories
+ * and 2 ratings, held as entity::Event. Not a test, run it by hand (Linux only, reads VmRSS).
+ *
+ * To compare with a tree from before InternedString, build it against that tree:
+ *   git worktree add /tmp/before <commit>
+ *   g++ -std=c++17 -O2 -I/tmp/before/src tests/EventMemory.cpp -o event_memory_before
+ */
+
+#include "tvheadend/entity/Event.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tvheadend::entity;
+
+namespace
+{
+
+const int EVENTS = 500000;
+const int SERIES = 4000;
+const int CHANNELS = 200;
+
+/*
+ * @return the resident memory of the process in KiB
+ */
+long GetResidentMemory()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.rfind("VmRSS:", 0) == 0)
+      return std::stol(line.substr(6));
+  }
+  return 0;
+}
+
+} // unnamed namespace
+
+int main()
+{
+  const char* categories[] = {"Movie / Drama",    "News / Current affairs",
+                              "Children's / Youth programmes", "Sports",
+                              "Show / Game show", "Documentary"};
+
+  const long before = GetResidentMemory();
+
+  std::vector<Event> events;
+  events.reserve(EVENTS);
+  for (int i = 0; i < EVENTS; ++i)
+  {
+    const std::string series = std::to_string(i % SERIES);
+    const bool fsk12 = i % 3 != 0;
+
+    Event event;
+    event.SetId(i);
+    event.SetChannel(i % CHANNELS);
+    event.SetTitle("Series title number " + series);
+    event.SetDesc("Unique description of event " + std::to_string(i) +
+                  " with a fair amount of text in it");
+    event.SetSeriesLink("crid://broadcaster.example.com/series/" + series);
+    event.SetCategories(std::string(categories[i % 6]));
+    event.SetCast("Actor One of series " + series + ", Actor Two, Actor Three");
+    event.SetDirectors("Director of series " + series);
+    event.SetWriters("Writer of series " + series);
+    event.SetRatingLabel(fsk12 ? "FSK 12" : "FSK 16");
+    event.SetRatingIcon(fsk12 ? "https://images.example.com/ratings/fsk12.png"
+                              : "https://images.example.com/ratings/fsk16.png");
+    event.SetRatingSource("Freiwillige Selbstkontrolle der Filmwirtschaft");
+    event.SetAired("2021-0" + std::to_string(1 + i % 9) + "-1" + std::to_string(i % 10));
+    events.push_back(event);
+  }
+
+  const long used = GetResidentMemory() - before;
+  std::printf("%d events: %ld KiB (%ld MiB) resident\n", EVENTS, used, used / 1024);
+  return 0;
+}
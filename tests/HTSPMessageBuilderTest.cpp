@@ -0,0 +1,131 @@
+/*
+ *  Copyright (C) 2005-2021 Team Kodi (https://kodi.tv)
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "tvheadend/HTSPMessageBuilder.h"
+
+extern "C"
+{
+#include "libhts/htsmsg.h"
+#include "libhts/htsmsg_binary.h"
+}
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <vector>
+
+using namespace tvheadend;
+
+namespace
+{
+
+int failures = 0;
+
+/*
+ * Encodes the same fields with htsmsg_binary_serialize and HTSPMessageBuilder and compares the
+ * bytes
+ */
+void Check(const char* test,
+           const std::function<void(htsmsg_t*)>& addMsg,
+           const std::function<void(HTSPMessageBuilder&)>& addBuilder)
+{
+  htsmsg_t* m = htsmsg_create_map();
+  addMsg(m);
+
+  void* data = nullptr;
+  size_t len = 0;
+  if (htsmsg_binary_serialize(m, &data, &len, std::numeric_limits<int>::max()) < 0)
+  {
+    std::printf("FAIL %s: htsmsg_binary_serialize failed\n", test);
+    htsmsg_destroy(m);
+    ++failures;
+    return;
+  }
+  htsmsg_destroy(m);
+
+  std::vector<uint8_t> buffer;
+  HTSPMessageBuilder builder(buffer);
+  addBuilder(builder);
+  const std::vector<uint8_t>& built = builder.Finish();
+
+  const uint8_t* expected = static_cast<const uint8_t*>(data);
+  if (built != std::vector<uint8_t>(expected, expected + len))
+  {
+    std::printf("FAIL %s: %zu bytes expected, %zu bytes built\n", test, len, built.size());
+    ++failures;
+  }
+  else
+    std::printf("ok   %s\n", test);
+
+  std::free(data);
+}
+
+void CheckS64(const char* test, int64_t value)
+{
+  Check(
+      test, [value](htsmsg_t* m) { htsmsg_add_s64(m, "value", value); },
+      [value](HTSPMessageBuilder& b) { b.AddS64("value", value); });
+}
+
+} // unnamed namespace
+
+int main()
+{
+  Check(
+      "empty message", [](htsmsg_t*) {}, [](HTSPMessageBuilder&) {});
+
+  CheckS64("s64 zero", 0);
+  CheckS64("s64 one", 1);
+  CheckS64("s64 negative", -1);
+  CheckS64("s64 large negative", -123456789012LL);
+  CheckS64("s64 max", std::numeric_limits<int64_t>::max());
+  CheckS64("s64 min", std::numeric_limits<int64_t>::min());
+  CheckS64("s64 uint32 max", std::numeric_limits<uint32_t>::max());
+
+  Check(
+      "empty string", [](htsmsg_t* m) { htsmsg_add_str(m, "value", ""); },
+      [](HTSPMessageBuilder& b) { b.AddStr("value", ""); });
+
+  Check(
+      "string", [](htsmsg_t* m) { htsmsg_add_str(m, "value", "Das Erste HD"); },
+      [](HTSPMessageBuilder& b) { b.AddStr("value", "Das Erste HD"); });
+
+  static const uint8_t bin[] = {0x00, 0x01, 0xff, 0x00, 0x80, 0x7f};
+  Check(
+      "binary", [](htsmsg_t* m) { htsmsg_add_bin(m, "value", bin, sizeof(bin)); },
+      [](HTSPMessageBuilder& b) { b.AddBin("value", bin, sizeof(bin)); });
+
+  Check(
+      "empty binary", [](htsmsg_t* m) { htsmsg_add_bin(m, "value", bin, 0); },
+      [](HTSPMessageBuilder& b) { b.AddBin("value", bin, 0); });
+
+  /* As sent by HTSPConnection::SendAsync for a fileRead */
+  Check(
+      "request",
+      [](htsmsg_t* m)
+      {
+        htsmsg_add_u32(m, "id", 7);
+        htsmsg_add_s64(m, "size", 256 * 1024);
+        htsmsg_add_s64(m, "offset", 0x123456789LL);
+        htsmsg_add_u32(m, "seq", 42);
+        htsmsg_add_str(m, "method", "fileRead");
+      },
+      [](HTSPMessageBuilder& b)
+      {
+        for (const HTSPField& field : {HTSPField("id", 7u), HTSPField("size", 256 * 1024),
+                                       HTSPField("offset", int64_t{0x123456789LL})})
+          b.Add(field);
+        b.AddS64("seq", 42).AddStr("method", "fileRead");
+      });
+
+  if (failures)
+    std::printf("%d test(s) failed\n", failures);
+
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}